@@ -0,0 +1,52 @@
+const initEnvironment = require(`eosiac`);
+const { getAccountNames } = require(`./_helpers`);
+
+const envName = process.env.EOSIAC_ENV || `dev`;
+
+const { api, sendTransaction, env } = initEnvironment(envName, { verbose: true });
+
+const {
+  IBC_CONTRACT,
+} = getAccountNames();
+
+
+async function action() {
+  const thisChain = envName.includes(`wax`) ? `wax` : `eos`;
+  const otherChain = thisChain === `eos` ? `wax` : `eos`;
+  const SYMBOL_CODE = thisChain === `wax` ? `WEOSDT` : `EOSDT`;
+  const { IBC_CONTRACT: X_CHAIN_IBC_CONTRACT } = getAccountNames(
+    envName === `kylin` ? `waxtest` : `kylin`
+  );
+
+  try {
+    await sendTransaction([
+      {
+        account: IBC_CONTRACT,
+        name: `setchain`,
+        authorization: [
+          {
+            actor: IBC_CONTRACT,
+            permission: `active`,
+          },
+        ],
+        data: {
+          chain_name: otherChain,
+          ibc_contract: X_CHAIN_IBC_CONTRACT,
+          // 0 uses settings.min_quantity
+          min_quantity: `0.000000000 ${SYMBOL_CODE}`,
+          // null uses fees.fees_percentage
+          fees_percentage: null,
+          enabled: true,
+        },
+      },
+    ]);
+
+    process.exit(0);
+  } catch (error) {
+    console.error(error.message);
+    // ignore
+    process.exit(1);
+  }
+}
+
+action();
@@ -19,6 +19,9 @@ async function action() {
     const otherChain = thisChain === `eos` ? `wax` : `eos`;
     const SYMBOL_CODE = thisChain === `wax` ? `WEOSDT` : `EOSDT`;
     const TOKEN_CONTRACT = `eosdtsttoken`
+    const { IBC_CONTRACT: X_CHAIN_IBC_CONTRACT } = getAccountNames(
+      envName === `kylin` ? `waxtest` : `kylin`
+    );
 
     await sendTransaction([
       {
@@ -43,6 +46,25 @@ async function action() {
           min_quantity: `1.000000000 ${SYMBOL_CODE}`,
         },
       },
+      {
+        account: IBC_CONTRACT,
+        name: `setchain`,
+        authorization: [
+          {
+            actor: IBC_CONTRACT,
+            permission: `active`,
+          },
+        ],
+        data: {
+          chain_name: otherChain,
+          ibc_contract: X_CHAIN_IBC_CONTRACT,
+          // 0 uses settings.min_quantity
+          min_quantity: `0.000000000 ${SYMBOL_CODE}`,
+          // null uses fees.fees_percentage
+          fees_percentage: null,
+          enabled: true,
+        },
+      },
       {
         account: IBC_CONTRACT,
         name: `enable`,
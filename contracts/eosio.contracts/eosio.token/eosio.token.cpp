@@ -100,6 +100,38 @@ void token::transfer( const name&    from,
     add_balance( to, quantity, payer );
 }
 
+void token::transfermany( const name&                                  from,
+                          const std::vector<std::pair<name, asset>>&   outputs,
+                          const string&                                memo )
+{
+    require_auth( from );
+    check( !outputs.empty(), "no outputs" );
+    check( memo.size() <= 256, "memo has more than 256 bytes" );
+
+    auto sym = outputs.front().second.symbol;
+    stats statstable( get_self(), sym.code().raw() );
+    const auto& st = statstable.get( sym.code().raw() );
+    check( sym == st.supply.symbol, "symbol precision mismatch" );
+
+    asset total( 0, sym );
+    for( const auto& [to, quantity] : outputs ) {
+        check( from != to, "cannot transfer to self" );
+        check( is_account( to ), "to account does not exist");
+        check( quantity.is_valid(), "invalid quantity" );
+        check( quantity.amount > 0, "must transfer positive quantity" );
+        check( quantity.symbol == sym, "all outputs must have the same symbol" );
+        total += quantity;
+    }
+
+    require_recipient( from );
+    sub_balance( from, total );
+
+    for( const auto& [to, quantity] : outputs ) {
+        require_recipient( to );
+        add_balance( to, quantity, has_auth( to ) ? to : from );
+    }
+}
+
 void token::sub_balance( const name& owner, const asset& value ) {
    accounts from_acnts( get_self(), owner.value );
 
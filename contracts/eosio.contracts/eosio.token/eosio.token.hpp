@@ -5,6 +5,8 @@
 #include <eosio/eosio.hpp>
 
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace eosiosystem {
    class system_contract;
@@ -70,6 +72,21 @@ namespace eosio {
                         const name&    to,
                         const asset&   quantity,
                         const string&  memo );
+         /**
+          * Allows `from` account to pay several accounts in one action.
+          * The token stats are read once, `from` is debited once with the sum of all outputs
+          * and every recipient is credited and notified as with `transfer`.
+          *
+          * @param from - the account to transfer from,
+          * @param outputs - pairs of recipient and quantity, all of the same token,
+          * @param memo - the memo string to accompany the transaction.
+          *
+          * @pre `outputs` must not be empty and must not contain `from`.
+          */
+         [[eosio::action]]
+         void transfermany( const name&                                  from,
+                            const std::vector<std::pair<name, asset>>&   outputs,
+                            const string&                                memo );
          /**
           * Allows `ram_payer` to create an account `owner` with zero balance for
           * token `symbol` at the expense of `ram_payer`.
@@ -115,6 +132,7 @@ namespace eosio {
          using issue_action = eosio::action_wrapper<"issue"_n, &token::issue>;
          using retire_action = eosio::action_wrapper<"retire"_n, &token::retire>;
          using transfer_action = eosio::action_wrapper<"transfer"_n, &token::transfer>;
+         using transfermany_action = eosio::action_wrapper<"transfermany"_n, &token::transfermany>;
          using open_action = eosio::action_wrapper<"open"_n, &token::open>;
          using close_action = eosio::action_wrapper<"close"_n, &token::close>;
       private:
@@ -0,0 +1,17 @@
+# Prints the WASM size of a profile build next to the generic build.
+# cmake -DPROFILE=<name> -DPROFILE_WASM=<path> -DGENERIC_WASM=<path> -P wasm_size.cmake
+cmake_minimum_required(VERSION 3.14)
+
+if(NOT EXISTS ${GENERIC_WASM})
+   message(WARNING "No generic build at ${GENERIC_WASM}, build it first to compare WASM sizes")
+   return()
+endif()
+
+file(SIZE ${PROFILE_WASM} profile_size)
+file(SIZE ${GENERIC_WASM} generic_size)
+math(EXPR saved "${generic_size} - ${profile_size}")
+math(EXPR saved_permille "${saved} * 1000 / ${generic_size}")
+math(EXPR saved_percent "${saved_permille} / 10")
+math(EXPR saved_percent_fraction "${saved_permille} % 10")
+
+message(STATUS "reporteribc WASM size: generic ${generic_size} bytes, profile ${PROFILE} ${profile_size} bytes (${saved} bytes / ${saved_percent}.${saved_percent_fraction}% smaller)")
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <eosio/multi_index.hpp>
+#include <eosio/singleton.hpp>
+
+// Database operation counters for measuring the cost of an action.
+// Build with -DREPORTERIBC_INSTRUMENT=ON to wrap every table and sent action
+// of the contract; without it the aliases below resolve to the plain eosio
+// types.
+#ifdef REPORTERIBC_INSTRUMENT
+#include <eosio/print.hpp>
+
+namespace instrument {
+
+struct db_counters {
+  // find, require_find and get
+  uint32_t find = 0;
+  // lower_bound, upper_bound and begin
+  uint32_t seek = 0;
+  // iterator increments / decrements
+  uint32_t next = 0;
+  uint32_t emplace = 0;
+  uint32_t modify = 0;
+  uint32_t erase = 0;
+  uint32_t singleton_read = 0;
+  uint32_t singleton_write = 0;
+  uint32_t inline_action = 0;
+};
+
+// every action runs in a fresh wasm instance, so these start at zero
+inline db_counters counters;
+
+
+inline void print_summary() {
+  eosio::print("dbops find=", counters.find, " seek=", counters.seek,
+               " next=", counters.next, " emplace=", counters.emplace,
+               " modify=", counters.modify, " erase=", counters.erase,
+               " sread=", counters.singleton_read,
+               " swrite=", counters.singleton_write,
+               " inline=", counters.inline_action, "\n");
+}
+
+template <typename Iterator>
+class counted_iterator {
+ public:
+  explicit counted_iterator(const Iterator &it) : _it(it) {}
+
+  const auto &operator*() const { return *_it; }
+  const auto *operator->() const { return &*_it; }
+
+  counted_iterator &operator++() {
+    counters.next++;
+    ++_it;
+    return *this;
+  }
+  counted_iterator operator++(int) {
+    counted_iterator copy(*this);
+    ++(*this);
+    return copy;
+  }
+  counted_iterator &operator--() {
+    counters.next++;
+    --_it;
+    return *this;
+  }
+  counted_iterator operator--(int) {
+    counted_iterator copy(*this);
+    --(*this);
+    return copy;
+  }
+
+  bool operator==(const counted_iterator &b) const { return _it == b._it; }
+  bool operator!=(const counted_iterator &b) const { return _it != b._it; }
+
+  const Iterator &base() const { return _it; }
+
+ private:
+  Iterator _it;
+};
+
+template <typename Index>
+class counted_index {
+ public:
+  using const_iterator = counted_iterator<typename Index::const_iterator>;
+
+  explicit counted_index(const Index &index) : _index(index) {}
+
+  const_iterator begin() const {
+    counters.seek++;
+    return const_iterator(_index.begin());
+  }
+  const_iterator end() const { return const_iterator(_index.end()); }
+
+  template <typename Key>
+  const_iterator find(const Key &key) const {
+    counters.find++;
+    return const_iterator(_index.find(key));
+  }
+  template <typename Key>
+  const_iterator require_find(
+      const Key &key, const char *error_msg = "unable to find key") const {
+    counters.find++;
+    return const_iterator(_index.require_find(key, error_msg));
+  }
+  template <typename Key>
+  const auto &get(const Key &key,
+                  const char *error_msg = "unable to find key") const {
+    counters.find++;
+    return _index.get(key, error_msg);
+  }
+  template <typename Key>
+  const_iterator lower_bound(const Key &key) const {
+    counters.seek++;
+    return const_iterator(_index.lower_bound(key));
+  }
+  template <typename Key>
+  const_iterator upper_bound(const Key &key) const {
+    counters.seek++;
+    return const_iterator(_index.upper_bound(key));
+  }
+
+  template <typename Lambda>
+  void modify(const const_iterator &it, eosio::name payer, Lambda &&updater) {
+    counters.modify++;
+    _index.modify(it.base(), payer, std::forward<Lambda>(updater));
+  }
+  const_iterator erase(const const_iterator &it) {
+    counters.erase++;
+    return const_iterator(_index.erase(it.base()));
+  }
+
+ private:
+  Index _index;
+};
+
+template <eosio::name::raw TableName, typename T, typename... Indices>
+class counted_multi_index
+    : public eosio::multi_index<TableName, T, Indices...> {
+  using base = eosio::multi_index<TableName, T, Indices...>;
+
+ public:
+  using const_iterator = counted_iterator<typename base::const_iterator>;
+  using base::base;
+
+  const_iterator begin() const {
+    counters.seek++;
+    return const_iterator(base::begin());
+  }
+  const_iterator end() const { return const_iterator(base::end()); }
+
+  const_iterator find(uint64_t primary) const {
+    counters.find++;
+    return const_iterator(base::find(primary));
+  }
+  const_iterator require_find(
+      uint64_t primary, const char *error_msg = "unable to find key") const {
+    counters.find++;
+    return const_iterator(base::require_find(primary, error_msg));
+  }
+  const T &get(uint64_t primary,
+               const char *error_msg = "unable to find key") const {
+    counters.find++;
+    return base::get(primary, error_msg);
+  }
+  const_iterator lower_bound(uint64_t primary) const {
+    counters.seek++;
+    return const_iterator(base::lower_bound(primary));
+  }
+  const_iterator upper_bound(uint64_t primary) const {
+    counters.seek++;
+    return const_iterator(base::upper_bound(primary));
+  }
+
+  template <typename Lambda>
+  const_iterator emplace(eosio::name payer, Lambda &&constructor) {
+    counters.emplace++;
+    return const_iterator(
+        base::emplace(payer, std::forward<Lambda>(constructor)));
+  }
+  template <typename Lambda>
+  void modify(const const_iterator &it, eosio::name payer, Lambda &&updater) {
+    counters.modify++;
+    base::modify(it.base(), payer, std::forward<Lambda>(updater));
+  }
+  const_iterator erase(const const_iterator &it) {
+    counters.erase++;
+    return const_iterator(base::erase(it.base()));
+  }
+
+  template <eosio::name::raw IndexName>
+  auto get_index() {
+    auto index = base::template get_index<IndexName>();
+    return counted_index<decltype(index)>(index);
+  }
+};
+
+template <eosio::name::raw SingletonName, typename T>
+class counted_singleton : public eosio::singleton<SingletonName, T> {
+  using base = eosio::singleton<SingletonName, T>;
+
+ public:
+  using base::base;
+
+  bool exists() {
+    counters.singleton_read++;
+    return base::exists();
+  }
+  T get() {
+    counters.singleton_read++;
+    return base::get();
+  }
+  T get_or_default(const T &def = T()) {
+    counters.singleton_read++;
+    return base::get_or_default(def);
+  }
+  void set(const T &value, eosio::name payer) {
+    counters.singleton_write++;
+    base::set(value, payer);
+  }
+};
+
+// action_wrapper whose send() counts the inline action
+template <typename Wrapper>
+struct counted_action : Wrapper {
+  using Wrapper::Wrapper;
+
+  template <typename... Args>
+  void send(Args &&... args) const {
+    counters.inline_action++;
+    Wrapper::send(std::forward<Args>(args)...);
+  }
+};
+
+template <eosio::name::raw TableName, typename T, typename... Indices>
+using multi_index = counted_multi_index<TableName, T, Indices...>;
+template <eosio::name::raw SingletonName, typename T>
+using singleton = counted_singleton<SingletonName, T>;
+template <typename Wrapper>
+using action = counted_action<Wrapper>;
+
+}  // namespace instrument
+
+#else
+
+namespace instrument {
+
+template <eosio::name::raw TableName, typename T, typename... Indices>
+using multi_index = eosio::multi_index<TableName, T, Indices...>;
+template <eosio::name::raw SingletonName, typename T>
+using singleton = eosio::singleton<SingletonName, T>;
+template <typename Wrapper>
+using action = Wrapper;
+
+}  // namespace instrument
+
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <eosio/name.hpp>
+#include <eosio/symbol.hpp>
+
+// Compile-time deployment profile.
+// Build with -DREPORTERIBC_PROFILE=<name> to bake the immutable settings of a
+// deployment from profiles/<name>.hpp into the contract; without it they are
+// read from the settings singleton.
+namespace profile {
+
+struct peer_chain {
+  eosio::name chain_name;
+  eosio::name ibc_contract;
+};
+
+}  // namespace profile
+
+#ifdef REPORTERIBC_PROFILE_HEADER
+#include REPORTERIBC_PROFILE_HEADER
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+
+// waxibc of tests/throughput.bench.js, destination of the simulated deposits
+namespace profile {
+
+constexpr eosio::name current_chain_name = eosio::name("wax");
+constexpr eosio::name token_contract = eosio::name("weosdt");
+constexpr eosio::symbol token_symbol =
+    eosio::symbol(eosio::symbol_code("WEOSDT"), 9);
+constexpr bool do_issue = true;
+constexpr peer_chain peer_chains[] = {
+    {eosio::name("eos"), eosio::name("eosibc")},
+};
+
+}  // namespace profile
@@ -0,0 +1,15 @@
+#pragma once
+
+// eosdttowaxxx on EOS, pays out EOSDT from its balance
+namespace profile {
+
+constexpr eosio::name current_chain_name = eosio::name("eos");
+constexpr eosio::name token_contract = eosio::name("eosdtsttoken");
+constexpr eosio::symbol token_symbol =
+    eosio::symbol(eosio::symbol_code("EOSDT"), 9);
+constexpr bool do_issue = false;
+constexpr peer_chain peer_chains[] = {
+    {eosio::name("wax"), eosio::name("weosdttoeoss")},
+};
+
+}  // namespace profile
@@ -1,6 +1,11 @@
 #include "reporteribc.hpp"
 #include "../eosio.contracts/eosio.token/eosio.token.hpp"
 
+using token_issue_action = instrument::action<token::issue_action>;
+using token_transfer_action = instrument::action<token::transfer_action>;
+using token_transfermany_action =
+    instrument::action<token::transfermany_action>;
+
 ACTION reporteribc::init(name current_chain_name, token_info token_info,
                          uint32_t expire_after_seconds, bool do_issue,
                          uint8_t threshold, double fees_percentage,
@@ -14,6 +19,13 @@ ACTION reporteribc::init(name current_chain_name, token_info token_info,
   check(min_quantity.amount >= 0, "min_quantity must be >= 0");
   check(token_info.symbol == min_quantity.symbol,
         "token info symbol does not match min_quantity symbol");
+#ifdef REPORTERIBC_PROFILE_HEADER
+  check(current_chain_name == profile::current_chain_name &&
+            token_info.contract == profile::token_contract &&
+            token_info.symbol == profile::token_symbol &&
+            do_issue == profile::do_issue,
+        "settings do not match the profile this contract was built for");
+#endif
 
   _settings_table.set(
       settings{
@@ -43,7 +55,7 @@ ACTION reporteribc::update(uint64_t threshold, double fees_percentage,
 
   check(threshold > 0, "minimum reporters must be positive");
   check(min_quantity.amount >= 0, "min_quantity must be >= 0");
-  check(_settings.token_info.symbol == min_quantity.symbol,
+  check(token_symbol() == min_quantity.symbol,
         "token info symbol does not match min_quantity symbol");
 
   _settings.threshold = threshold;
@@ -61,8 +73,10 @@ ACTION reporteribc::update(uint64_t threshold, double fees_percentage,
         count_non_empty(report->confirmed_by) >= threshold) {
       _reports_table.modify(report, eosio::same_payer,
                             [&](auto &s) { s.confirmed = true; });
+      report_confirmed(*report);
     }
   }
+  _telemetry_table.set(_telemetry, get_self());
 }
 
 ACTION reporteribc::enable(bool enable) {
@@ -72,6 +86,52 @@ ACTION reporteribc::enable(bool enable) {
   _settings_table.set(_settings, get_self());
 }
 
+ACTION reporteribc::setbatchpay(bool enable) {
+  require_auth(get_self());
+
+  _settings.batch_payouts.emplace(enable);
+  _settings_table.set(_settings, get_self());
+}
+
+ACTION reporteribc::setchain(name chain_name, name ibc_contract,
+                           const asset &min_quantity,
+                           std::optional<double> fees_percentage,
+                           bool enabled) {
+  require_auth(get_self());
+
+  check(chain_name != current_chain_name(),
+        "cannot register the current chain");
+  check(min_quantity.amount >= 0, "min_quantity must be >= 0");
+  check(token_symbol() == min_quantity.symbol,
+        "token info symbol does not match min_quantity symbol");
+  check(!fees_percentage || (*fees_percentage >= 0 && *fees_percentage < 1),
+        "fees_percentage must be in [0, 1)");
+
+  auto set_chain = [&](auto &s) {
+    s.chain_name = chain_name;
+    s.ibc_contract = ibc_contract;
+    s.min_quantity = min_quantity;
+    s.fees_percentage = fees_percentage;
+    s.enabled = enabled;
+  };
+
+  auto it = _chains_table.find(chain_name.value);
+  if (it == _chains_table.end()) {
+    _chains_table.emplace(get_self(), set_chain);
+  } else {
+    _chains_table.modify(it, eosio::same_payer, set_chain);
+  }
+}
+
+ACTION reporteribc::rmchain(name chain_name) {
+  require_auth(get_self());
+  auto it = _chains_table.find(chain_name.value);
+
+  check(it != _chains_table.end(), "chain does not exist");
+
+  _chains_table.erase(it);
+}
+
 ACTION reporteribc::addreporter(name reporter) {
   require_auth(get_self());
   check(is_account(reporter), "reporter account does not exist");
@@ -101,8 +161,37 @@ void reporteribc::clearexpired(uint64_t count) {
   expired_reports_t expired_reports_table(get_self(), get_self().value);
   for (auto it = expired_reports_table.begin();
        it != expired_reports_table.end() && current_count < count;
-       current_count++, it++) {
-    expired_reports_table.erase(it);
+       current_count++) {
+    it = expired_reports_table.erase(it);
+  }
+}
+
+void reporteribc::purgearchive(time_point_sec before, uint32_t max_rows) {
+  require_auth(get_self());
+
+  archived_reports_t archive(get_self(), get_self().value);
+  auto archive_by_expiry = archive.get_index<"byexpiry"_n>();
+  auto end = archive_by_expiry.lower_bound(before.sec_since_epoch());
+  uint32_t count = 0;
+  for (auto it = archive_by_expiry.begin(); it != end && count < max_rows;
+       count++) {
+    it = archive_by_expiry.erase(it);
+  }
+}
+
+void reporteribc::exportarchive(uint64_t from_id, uint32_t limit, bool erase) {
+  require_auth(get_self());
+
+  archived_reports_t archive(get_self(), get_self().value);
+  uint32_t count = 0;
+  for (auto it = archive.lower_bound(from_id);
+       it != archive.end() && count < limit; count++) {
+    evexpired_action(get_self(), {get_self(), "active"_n}).send(*it);
+    if (erase) {
+      it = archive.erase(it);
+    } else {
+      ++it;
+    }
   }
 }
 
@@ -146,6 +235,7 @@ ACTION reporteribc::issuefees() {
   check(total_points > (_settings.threshold + 1) * 10,
         "not enough transfers have been processed since last time");
 
+  std::vector<std::pair<name, asset>> outputs;
   for (auto reporter = _reporters_table.begin();
        reporter != _reporters_table.end(); reporter++) {
     double share = (double)reporter->points / total_points;
@@ -159,9 +249,19 @@ ACTION reporteribc::issuefees() {
     });
 
     if (share_fees.amount > 0) {
-      token::transfer_action transfer_act(_settings.token_info.contract,
-                                          {get_self(), name("active")});
-      transfer_act.send(get_self(), reporter->account, share_fees, "fees");
+      outputs.emplace_back(reporter->account, share_fees);
+    }
+  }
+
+  if (batch_payouts() && !outputs.empty()) {
+    token_transfermany_action transfermany_act(token_contract(),
+                                               {get_self(), name("active")});
+    transfermany_act.send(get_self(), outputs, "fees");
+  } else {
+    for (const auto &[account, share_fees] : outputs) {
+      token_transfer_action transfer_act(token_contract(),
+                                         {get_self(), name("active")});
+      transfer_act.send(get_self(), account, share_fees, "fees");
     }
   }
 
@@ -178,6 +278,10 @@ ACTION reporteribc::report(name reporter, const transfer_s &transfer) {
   check_reporter(reporter);
   reporter_worked(reporter);
   check(transfer.expires_at > current_time_point(), "transfer already expired");
+  check(transfer.to_blockchain == current_chain_name(),
+        "transfer is not addressed to this chain");
+  check(is_enabled_peer(transfer.from_blockchain),
+        "transfer is not from a registered chain");
   free_ram();
 
   // we don't want report to fail, report anything at this point
@@ -202,7 +306,7 @@ ACTION reporteribc::report(name reporter, const transfer_s &transfer) {
 
   // first reporter
   if (new_report) {
-    _reports_table.emplace(reporter, [&](auto &s) {
+    auto created = _reports_table.emplace(reporter, [&](auto &s) {
       auto reserved_capacity = get_num_reporters();
       s.id = _reports_table.available_primary_key();
       s.transfer = transfer;
@@ -216,6 +320,10 @@ ACTION reporteribc::report(name reporter, const transfer_s &transfer) {
       s.confirmed = 1 >= _settings.threshold;
       s.executed = false;
     });
+    _telemetry.reports_created++;
+    if (created->confirmed) {
+      report_confirmed(*created);
+    }
   } else {
     // checks that the reporter didn't already report the transfer
     check(std::find(report->confirmed_by.begin(), report->confirmed_by.end(),
@@ -224,11 +332,16 @@ ACTION reporteribc::report(name reporter, const transfer_s &transfer) {
 
     // can use same_payer here because confirmed_by has enough capacity
     // unless a new reporter was added in between
+    bool was_confirmed = report->confirmed;
     reports_by_transfer.modify(report, eosio::same_payer, [&](auto &s) {
       push_first_free(s.confirmed_by, reporter);
       s.confirmed = count_non_empty(s.confirmed_by) >= _settings.threshold;
     });
+    if (!was_confirmed && report->confirmed) {
+      report_confirmed(*report);
+    }
   }
+  _telemetry_table.set(_telemetry, get_self());
 }
 
 ACTION reporteribc::exec(name reporter, uint64_t report_id) {
@@ -238,32 +351,26 @@ ACTION reporteribc::exec(name reporter, uint64_t report_id) {
   reporter_worked(reporter);
   free_ram();
 
-  auto report = _reports_table.find(report_id);
-  check(report != _reports_table.end(), "report does not exist");
-  check(report->confirmed, "not confirmed yet");
-  check(!report->executed, "already executed");
-  check(!report->failed, "transfer already failed");
-  check(report->transfer.expires_at > current_time_point(),
-        "report's transfer already expired");
+  pay_out({settle_report(report_id)});
+  _telemetry_table.set(_telemetry, get_self());
+}
 
-  name token_contract = _settings.token_info.contract;
-  // convert original symbol to symbol on this chain
-  asset quantity =
-      asset(report->transfer.quantity.amount, _settings.token_info.symbol);
+ACTION reporteribc::execmany(name reporter,
+                             const std::vector<uint64_t> &report_ids) {
+  check_enabled();
+  require_auth(reporter);
+  check_reporter(reporter);
+  check(!report_ids.empty(), "no reports to execute");
+  reporter_worked(reporter, report_ids.size());
+  free_ram();
 
-  // if it's a refund we never issue new tokens, because they are still in the
-  // contract
-  if (!report->transfer.is_refund && _settings.do_issue) {
-    // issue tokens first, self must be issuer of token
-    token::issue_action issue_act(token_contract, {get_self(), "active"_n});
-    issue_act.send(get_self(), quantity, "");
+  std::vector<payout> payouts;
+  payouts.reserve(report_ids.size());
+  for (auto report_id : report_ids) {
+    payouts.push_back(settle_report(report_id));
   }
-
-  token::transfer_action transfer_act(token_contract, {get_self(), "active"_n});
-  transfer_act.send(get_self(), report->transfer.to_account, quantity, "");
-
-  _reports_table.modify(report, eosio::same_payer,
-                        [&](auto &s) { s.executed = true; });
+  pay_out(payouts);
+  _telemetry_table.set(_telemetry, get_self());
 }
 
 ACTION reporteribc::execfailed(name reporter, uint64_t report_id) {
@@ -292,6 +399,10 @@ ACTION reporteribc::execfailed(name reporter, uint64_t report_id) {
 
   // init a cross-chain refund transfer
   if (failed) {
+    _telemetry.failures++;
+    evfailed_action(get_self(), {get_self(), "active"_n})
+        .send(report_event{report->id, report->transfer.from_blockchain,
+                           report->transfer.id});
     // if original transfer already was a refund
     // stop refund ping pong and just record it in a table requiring manual
     // review
@@ -301,13 +412,36 @@ ACTION reporteribc::execfailed(name reporter, uint64_t report_id) {
       //                                [&](auto &x) { x = report->transfer; });
     } else {
       auto to_blockchain = report->transfer.from_blockchain;
-      auto from = get_ibc_contract_for_chain(report->transfer.to_blockchain);
+      // the refund is sent back on behalf of the origin chain's contract
+      auto from = get_ibc_contract_for_chain(report->transfer.from_blockchain);
       auto to = report->transfer.from_account;
       auto quantity =
-          asset(report->transfer.quantity.amount, _settings.token_info.symbol);
+          asset(report->transfer.quantity.amount, token_symbol());
       register_transfer(to_blockchain, from, to, quantity, true);
     }
   }
+  _telemetry_table.set(_telemetry, get_self());
+}
+
+// event log actions only show up in the action traces
+ACTION reporteribc::evtransfer(const transfer_s &transfer) {
+  require_auth(get_self());
+}
+
+ACTION reporteribc::evconfirm(const report_event &event) {
+  require_auth(get_self());
+}
+
+ACTION reporteribc::evexec(const report_event &event) {
+  require_auth(get_self());
+}
+
+ACTION reporteribc::evfailed(const report_event &event) {
+  require_auth(get_self());
+}
+
+ACTION reporteribc::evexpired(const archived_report_s &report) {
+  require_auth(get_self());
 }
 
 void reporteribc::on_transfer(name from, name to, asset quantity, string memo) {
@@ -317,14 +451,12 @@ void reporteribc::on_transfer(name from, name to, asset quantity, string memo) {
       from == "eosio.rex"_n)
     return;
 
-  if (get_first_receiver() != _settings.token_info.contract)
+  if (get_first_receiver() != token_contract())
     return;
 
   check(to == get_self(), "contract not involved in transfer");
-  check(quantity.symbol == _settings.token_info.symbol,
+  check(quantity.symbol == token_symbol(),
         "correct token contract, but wrong symbol");
-  check(quantity >= _settings.min_quantity,
-        "sent quantity is less than required min quantity");
 
   const memo_x_transfer &memo_object = parse_memo(memo);
 
@@ -335,17 +467,40 @@ void reporteribc::on_transfer(name from, name to, asset quantity, string memo) {
 
   name to_blockchain_name = name(to_blockchain);
 
-  check(to_blockchain_name == name("eos") || to_blockchain_name == name("wax"),
+  check(current_chain_name() != to_blockchain_name,
+        "cannot send to the same chain");
+  // a row is only required for chains missing from the profile, for profile
+  // peers it can still disable the chain or override the min quantity
+  const bool profile_peer = is_profile_peer(to_blockchain_name);
+  auto chain = _chains_table.find(to_blockchain_name.value);
+  const bool has_row = chain != _chains_table.end();
+  check(has_row ? chain->enabled : profile_peer,
         "invalid memo: target blockchain \"" + to_blockchain +
             "\" is not valid");
-  check(_settings.current_chain_name != to_blockchain_name,
-        "cannot send to the same chain");
+  check(quantity >= (has_row && chain->min_quantity.amount > 0
+                         ? chain->min_quantity
+                         : _settings.min_quantity),
+        "sent quantity is less than required min quantity");
   check(memo_object.to_account.size() > 0 && memo_object.to_account.size() < 13,
         "invalid memo: target name \"" + memo_object.to_account +
             "\" is not valid");
 
   register_transfer(to_blockchain_name, from, name(memo_object.to_account),
                     quantity, false);
+  _telemetry_table.set(_telemetry, get_self());
+}
+
+void reporteribc::on_transfermany(
+    name from, const std::vector<std::pair<name, asset>> &outputs,
+    string memo) {
+  // our own batched payouts
+  if (from == get_self() || get_first_receiver() != token_contract()) return;
+
+  for (const auto &[to, quantity] : outputs) {
+    check(to != get_self(),
+          "deposits must use transfer, transfermany to the bridge is not "
+          "registered");
+  }
 }
 
 void reporteribc::register_transfer(const name &to_blockchain, const name &from,
@@ -356,17 +511,23 @@ void reporteribc::register_transfer(const name &to_blockchain, const name &from,
   const auto transfer_id = _settings.next_transfer_id;
   _settings.next_transfer_id += 1;
 
-  auto fees = asset(is_refund ? 0 : _fees.fees_percentage * quantity.amount,
+  double fees_percentage = _fees.fees_percentage;
+  auto chain = _chains_table.find(to_blockchain.value);
+  if (chain != _chains_table.end()) {
+    fees_percentage = chain->fees_percentage.value_or(fees_percentage);
+  }
+
+  auto fees = asset(is_refund ? 0 : fees_percentage * quantity.amount,
                     quantity.symbol);
   auto quantity_after_fees = quantity - fees;
   _fees.reserve += fees;
   _fees.total += fees;
 
   // record this transfer in case we need to refund it
-  _transfers_table.emplace(get_self(), [&](auto &x) {
+  auto transfer = _transfers_table.emplace(get_self(), [&](auto &x) {
     x.id = transfer_id;
     x.transaction_id = get_trx_id();
-    x.from_blockchain = _settings.current_chain_name;
+    x.from_blockchain = current_chain_name();
     x.to_blockchain = to_blockchain;
     x.from_account = from;
     x.to_account = to_account;
@@ -376,15 +537,85 @@ void reporteribc::register_transfer(const name &to_blockchain, const name &from,
     x.is_refund = is_refund;
   });
 
+  evtransfer_action(get_self(), {get_self(), "active"_n}).send(*transfer);
+
+  _telemetry.transfers_registered++;
+  if (is_refund) {
+    _telemetry.refunds++;
+  }
+
   _fees_table.set(_fees, get_self());
   _settings_table.set(_settings, get_self());
 }
 
-void reporteribc::reporter_worked(const name &reporter) {
+void reporteribc::reporter_worked(const name &reporter, uint64_t points) {
   auto it = _reporters_table.find(reporter.value);
   check(it != _reporters_table.end(), "reporter does not exist while PoW");
 
-  _reporters_table.modify(it, eosio::same_payer, [&](auto &s) { s.points++; });
+  _reporters_table.modify(it, eosio::same_payer,
+                          [&](auto &s) { s.points += points; });
+}
+
+// checks that the report can be executed and marks it as executed
+reporteribc::payout reporteribc::settle_report(uint64_t report_id) {
+  auto report = _reports_table.find(report_id);
+  check(report != _reports_table.end(), "report does not exist");
+  check(report->confirmed, "not confirmed yet");
+  check(!report->executed, "already executed");
+  check(!report->failed, "transfer already failed");
+  check(report->transfer.expires_at > current_time_point(),
+        "report's transfer already expired");
+
+  _reports_table.modify(report, eosio::same_payer,
+                        [&](auto &s) { s.executed = true; });
+
+  _telemetry.executions++;
+  record_latency(_telemetry.exec_latency, report->transfer);
+
+  return payout{
+      .to = report->transfer.to_account,
+      // convert original symbol to symbol on this chain
+      .quantity =
+          asset(report->transfer.quantity.amount, token_symbol()),
+      // if it's a refund we never issue new tokens, because they are still in
+      // the contract
+      .issue = !report->transfer.is_refund && do_issue(),
+      .event = report_event{report->id, report->transfer.from_blockchain,
+                            report->transfer.id},
+  };
+}
+
+void reporteribc::pay_out(const std::vector<payout> &payouts) {
+  asset issued = asset(0, token_symbol());
+  for (const auto &p : payouts) {
+    if (p.issue) issued += p.quantity;
+  }
+  if (issued.amount > 0) {
+    // issue tokens first, self must be issuer of token
+    token_issue_action issue_act(token_contract(), {get_self(), "active"_n});
+    issue_act.send(get_self(), issued, "");
+  }
+
+  if (batch_payouts() && payouts.size() > 1) {
+    std::vector<std::pair<name, asset>> outputs;
+    outputs.reserve(payouts.size());
+    for (const auto &p : payouts) {
+      outputs.emplace_back(p.to, p.quantity);
+    }
+    token_transfermany_action transfermany_act(token_contract(),
+                                               {get_self(), "active"_n});
+    transfermany_act.send(get_self(), outputs, "");
+  } else {
+    for (const auto &p : payouts) {
+      token_transfer_action transfer_act(token_contract(),
+                                         {get_self(), "active"_n});
+      transfer_act.send(get_self(), p.to, p.quantity, "");
+    }
+  }
+
+  for (const auto &p : payouts) {
+    evexec_action(get_self(), {get_self(), "active"_n}).send(p.event);
+  }
 }
 
 void reporteribc::free_ram() {
@@ -396,6 +627,7 @@ void reporteribc::free_ram() {
        it != transfers_by_expiry.upper_bound(now) && count < 2;
        count++, it = transfers_by_expiry.lower_bound(0)) {
     transfers_by_expiry.erase(it);
+    _telemetry.evicted++;
   }
 
   auto reports_by_expiry = _reports_table.get_index<name("byexpiry")>();
@@ -405,9 +637,58 @@ void reporteribc::free_ram() {
        count++, it = reports_by_expiry.lower_bound(0)) {
     // track reports that were not executed and where no refund was initiated
     if (!it->executed && !it->failed) {
-      expired_reports_t expired_reports_table(get_self(), get_self().value);
-      expired_reports_table.emplace(get_self(), [&](auto &x) { x = *it; });
+      archive_report(*it);
+      _telemetry.expired++;
     }
     reports_by_expiry.erase(it);
+    _telemetry.evicted++;
+  }
+}
+
+void reporteribc::archive_report(const report_s &report) {
+  uint64_t confirmed_mask = 0;
+  uint32_t index = 0;
+  for (auto reporter = _reporters_table.begin();
+       reporter != _reporters_table.end() && index < 64; reporter++, index++) {
+    if (std::find(report.confirmed_by.begin(), report.confirmed_by.end(),
+                  reporter->account) != report.confirmed_by.end()) {
+      confirmed_mask |= 1ULL << index;
+    }
   }
+
+  auto packed_transfer = pack(report.transfer);
+  archived_reports_t archive(get_self(), get_self().value);
+  archive.emplace(get_self(), [&](auto &a) {
+    a.id = archive.available_primary_key();
+    a.report_id = report.id;
+    a.transfer_digest = sha256(packed_transfer.data(), packed_transfer.size());
+    a.transfer_id = report.transfer.id;
+    a.from_blockchain = report.transfer.from_blockchain;
+    a.from_account = report.transfer.from_account;
+    a.to_account = report.transfer.to_account;
+    a.quantity = report.transfer.quantity;
+    a.expires_at = report.transfer.expires_at;
+    a.is_refund = report.transfer.is_refund;
+    a.confirmed_mask = confirmed_mask;
+  });
+}
+
+void reporteribc::report_confirmed(const report_s &report) {
+  _telemetry.reports_confirmed++;
+  record_latency(_telemetry.confirm_latency, report.transfer);
+
+  evconfirm_action(get_self(), {get_self(), "active"_n})
+      .send(report_event{report.id, report.transfer.from_blockchain,
+                         report.transfer.id});
+}
+
+void reporteribc::record_latency(std::vector<uint32_t> &histogram,
+                                 const transfer_s &transfer) {
+  if (histogram.size() < LATENCY_BUCKETS) {
+    histogram.resize(LATENCY_BUCKETS, 0);
+  }
+
+  uint32_t now = current_time_point().sec_since_epoch();
+  uint32_t since = transfer.transaction_time.sec_since_epoch();
+  histogram[latency_bucket(now > since ? now - since : 0)]++;
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <optional>
 #include <eosio/asset.hpp>
+#include <eosio/binary_extension.hpp>
 #include <eosio/crypto.hpp>
 #include <eosio/eosio.hpp>
 #include <eosio/singleton.hpp>
@@ -9,6 +11,8 @@
 #include <eosio/system.hpp>
 #include <eosio/transaction.hpp>
 
+#include "./instrument.hpp"
+#include "./profile.hpp"
 #include "./utils.hpp"
 
 using namespace eosio;
@@ -29,11 +33,19 @@ CONTRACT reporteribc : public contract {
         _fees_table(receiver, receiver.value),
         _transfers_table(receiver, receiver.value),
         _reporters_table(receiver, receiver.value),
-        _reports_table(receiver, receiver.value) {
+        _reports_table(receiver, receiver.value),
+        _telemetry_table(receiver, receiver.value),
+        _chains_table(receiver, receiver.value) {
     _settings = _settings_table.get_or_default();
     _fees = _fees_table.get_or_default();
+    _telemetry = _telemetry_table.get_or_default();
   }
 
+#ifdef REPORTERIBC_INSTRUMENT
+  // runs after the action handler, prints the database operations it did
+  ~reporteribc() { instrument::print_summary(); }
+#endif
+
   TABLE settings {
     name current_chain_name;
     // stores info about the token that needs to be issued
@@ -47,6 +59,9 @@ CONTRACT reporteribc : public contract {
     // how many reporters need to report a transfer for it to be confirmed
     uint8_t threshold;
     asset min_quantity;
+    // pay out fees and batched executions with a single transfermany, the
+    // token contract must implement it
+    eosio::binary_extension<bool> batch_payouts;
   };
 
   TABLE fees {
@@ -56,6 +71,23 @@ CONTRACT reporteribc : public contract {
     double fees_percentage = 0.002;
   };
 
+  // monotonic counters, read with a single get_table_rows call for monitoring
+  TABLE telemetry {
+    uint64_t transfers_registered = 0;
+    uint64_t reports_created = 0;
+    uint64_t reports_confirmed = 0;
+    uint64_t executions = 0;
+    uint64_t failures = 0;
+    uint64_t refunds = 0;
+    // transfers and reports evicted by free_ram
+    uint64_t evicted = 0;
+    // unprocessed reports archived to reports.arch
+    uint64_t expired = 0;
+    // seconds from transfer.transaction_time, see latency_bucket
+    std::vector<uint32_t> confirm_latency;
+    std::vector<uint32_t> exec_latency;
+  };
+
   struct [[eosio::table("transfer")]] transfer_s {
     uint64_t id; // settings.next_transfer_id
     checksum256 transaction_id;
@@ -105,6 +137,48 @@ CONTRACT reporteribc : public contract {
     }
   };
 
+  // compact record of an unprocessed report that expired, for manual review
+  TABLE [[eosio::table("archived")]] archived_report_s {
+    uint64_t id;
+    uint64_t report_id;
+    // sha256 of the packed transfer_s, to match it against the source chain
+    checksum256 transfer_digest;
+    uint64_t transfer_id;
+    name from_blockchain;
+    name from_account;
+    name to_account;
+    asset quantity;
+    time_point_sec expires_at;
+    bool is_refund;
+    // bit i is set if the i-th reporter, ordered by account, confirmed it
+    // (reporters at the time of archiving, the first 64)
+    uint64_t confirmed_mask;
+
+    uint64_t primary_key() const { return id; }
+    uint64_t by_expiry() const { return expires_at.sec_since_epoch(); }
+  };
+
+  // chains that transfers can be sent to
+  TABLE chain_info {
+    name chain_name;
+    // ibc contract on that chain
+    name ibc_contract;
+    // overrides settings.min_quantity if amount is positive
+    asset min_quantity;
+    // overrides fees.fees_percentage for transfers to this chain
+    std::optional<double> fees_percentage;
+    bool enabled = true;
+
+    uint64_t primary_key() const { return chain_name.value; }
+  };
+
+  // identifies a report in the event log, transfers are logged in full
+  struct report_event {
+    uint64_t report_id;
+    name from_blockchain;
+    uint64_t transfer_id;
+  };
+
   TABLE reporter_info {
     name account;
     uint64_t points = 0;
@@ -118,35 +192,77 @@ CONTRACT reporteribc : public contract {
               uint32_t expire_after_seconds, bool do_issue, uint8_t threshold, double fees_percentage, const asset& min_quantity);
   ACTION update(uint64_t threshold, double fees_percentage, uint32_t expire_after_seconds, const asset& min_quantity);
   ACTION enable(bool enable);
+  ACTION setbatchpay(bool enable);
+  ACTION setchain(name chain_name, name ibc_contract,
+                  const asset &min_quantity,
+                  std::optional<double> fees_percentage, bool enabled);
+  ACTION rmchain(name chain_name);
   ACTION addreporter(name reporter);
   ACTION rmreporter(name reporter);
   [[eosio::action("clear.trans")]] void cleartransfers(std::vector<uint64_t> ids);
   [[eosio::action("clear.rep")]] void  clearreports(std::vector<uint64_t> ids);
   [[eosio::action("clear.exp")]] void  clearexpired(uint64_t count);
+  // erases up to max_rows archived reports that expired before `before`
+  [[eosio::action("arch.purge")]] void purgearchive(time_point_sec before,
+                                                    uint32_t max_rows);
+  // logs up to `limit` archived reports starting at from_id as evexpired
+  // events, optionally erasing them
+  [[eosio::action("arch.export")]] void exportarchive(uint64_t from_id,
+                                                      uint32_t limit,
+                                                      bool erase);
   ACTION issuefees();
   ACTION report(name reporter, const transfer_s &transfer);
   ACTION exec(name reporter, uint64_t report_id);
+  // executes several confirmed reports, paying them out together
+  ACTION execmany(name reporter, const std::vector<uint64_t> &report_ids);
   ACTION execfailed(name reporter, uint64_t report_id);
+  // no-op event log, sent inline on every registered transfer, confirmed
+  // report, execution and failed execution for trace consumers
+  ACTION evtransfer(const transfer_s &transfer);
+  ACTION evconfirm(const report_event &event);
+  ACTION evexec(const report_event &event);
+  ACTION evfailed(const report_event &event);
+  ACTION evexpired(const archived_report_s &report);
 
   [[eosio::on_notify("*::transfer")]] void on_transfer(
       name from, name to, asset quantity, string memo);
+  // deposits have to use transfer, the memo of a transfermany has no
+  // per-output destination
+  [[eosio::on_notify("*::transfermany")]] void on_transfermany(
+      name from, const std::vector<std::pair<name, asset>> &outputs,
+      string memo);
 
  private:
   using transfer_action =
       action_wrapper<name("transfer"), &reporteribc::on_transfer>;
+  // inline actions are only sent through instrument::action wrappers
+  using evtransfer_action = instrument::action<
+      action_wrapper<"evtransfer"_n, &reporteribc::evtransfer>>;
+  using evconfirm_action = instrument::action<
+      action_wrapper<"evconfirm"_n, &reporteribc::evconfirm>>;
+  using evexec_action =
+      instrument::action<action_wrapper<"evexec"_n, &reporteribc::evexec>>;
+  using evfailed_action =
+      instrument::action<action_wrapper<"evfailed"_n, &reporteribc::evfailed>>;
+  using evexpired_action = instrument::action<
+      action_wrapper<"evexpired"_n, &reporteribc::evexpired>>;
 
-  typedef eosio::singleton<"settings"_n, settings> settings_t;
+  typedef instrument::singleton<"settings"_n, settings> settings_t;
   typedef eosio::multi_index<"settings"_n, settings>
       settings_dummy_for_abi;  // hack until abi generator generates correct name
-  typedef eosio::singleton<"fees"_n, fees> fees_t;
+  typedef instrument::singleton<"fees"_n, fees> fees_t;
   typedef eosio::multi_index<"fees"_n, fees>
       fees_dummy_for_abi;  // hack until abi generator generates correct name
-  typedef eosio::multi_index<"transfers"_n, transfer_s,
+  typedef instrument::singleton<"telemetry"_n, telemetry> telemetry_t;
+  typedef eosio::multi_index<"telemetry"_n, telemetry>
+      telemetry_dummy_for_abi;  // hack until abi generator generates correct name
+  typedef instrument::multi_index<"transfers"_n, transfer_s,
     indexed_by<"byexpiry"_n,
                   const_mem_fun<transfer_s, uint64_t, &transfer_s::by_expiry>>
     > transfers_t;
-  typedef eosio::multi_index<"reporters"_n, reporter_info> reporters_t;
-  typedef eosio::multi_index<
+  typedef instrument::multi_index<"reporters"_n, reporter_info> reporters_t;
+  typedef instrument::multi_index<"chains"_n, chain_info> chains_t;
+  typedef instrument::multi_index<
       "reports"_n, report_s,
       indexed_by<"bytransferid"_n,
                  const_mem_fun<report_s, uint128_t, &report_s::by_transfer_id>>,
@@ -154,23 +270,46 @@ CONTRACT reporteribc : public contract {
                  const_mem_fun<report_s, uint64_t, &report_s::by_expiry>>
       >
       reports_t;
+  // legacy full copies of unprocessed reports that expired, superseded by
+  // reports.arch; kept so existing rows can still be reviewed and cleared
+  typedef instrument::multi_index<"reports.expr"_n, report_s> expired_reports_t;
   // keeps track of unprocessed reports that expired for manual review
-  typedef eosio::multi_index<"reports.expr"_n, report_s> expired_reports_t;
+  typedef instrument::multi_index<
+      "reports.arch"_n, archived_report_s,
+      indexed_by<"byexpiry"_n, const_mem_fun<archived_report_s, uint64_t,
+                                             &archived_report_s::by_expiry>>>
+      archived_reports_t;
 
   void register_transfer(const name &to_blockchain, const name &from,
                          const name &to_account, const asset &quantity,
                          bool is_refund);
-  void reporter_worked(const name &reporter);
+  void reporter_worked(const name &reporter, uint64_t points = 1);
   void free_ram();
+  void archive_report(const report_s &report);
+
+  struct payout {
+    name to;
+    asset quantity;
+    // refunds are paid from the contract balance, never issued
+    bool issue;
+    report_event event;
+  };
+  payout settle_report(uint64_t report_id);
+  void pay_out(const std::vector<payout> &payouts);
+  void report_confirmed(const report_s &report);
+  void record_latency(std::vector<uint32_t> &histogram,
+                      const transfer_s &transfer);
 
   settings _settings;
   fees _fees;
+  telemetry _telemetry;
   settings_t _settings_table;
   fees_t _fees_table;
   transfers_t _transfers_table;
   reporters_t _reporters_table;
   reports_t _reports_table;
-
+  telemetry_t _telemetry_table;
+  chains_t _chains_table;
 
   checksum256 get_trx_id() {
     size_t size = transaction_size();
@@ -202,25 +341,56 @@ CONTRACT reporteribc : public contract {
           "the signer is not a known reporter");
   }
 
-  void check_enabled() {
-    auto _settings = _settings_table.get();
-    check(_settings.enabled, "reporting is disabled");
+  // settings already loaded in the constructor
+  void check_enabled() { check(_settings.enabled, "reporting is disabled"); }
+
+  bool batch_payouts() { return _settings.batch_payouts.value_or(false); }
+
+  // immutable settings, constants in a profile build
+#ifdef REPORTERIBC_PROFILE_HEADER
+  static constexpr name current_chain_name() {
+    return profile::current_chain_name;
+  }
+  static constexpr name token_contract() { return profile::token_contract; }
+  static constexpr symbol token_symbol() { return profile::token_symbol; }
+  static constexpr bool do_issue() { return profile::do_issue; }
+#else
+  name current_chain_name() const { return _settings.current_chain_name; }
+  name token_contract() const { return _settings.token_info.contract; }
+  symbol token_symbol() const { return _settings.token_info.symbol; }
+  bool do_issue() const { return _settings.do_issue; }
+#endif
+
+  // peers of a profile build are valid without a chains row
+  static constexpr bool is_profile_peer(name chain_name) {
+#ifdef REPORTERIBC_PROFILE_HEADER
+    for (const auto &peer : profile::peer_chains) {
+      if (peer.chain_name == chain_name) return true;
+    }
+#endif
+    return false;
+  }
+
+  // a chain transfers are accepted from, a disabled row overrides the profile
+  bool is_enabled_peer(name chain_name) {
+    auto chain = _chains_table.find(chain_name.value);
+    return chain != _chains_table.end() ? chain->enabled
+                                        : is_profile_peer(chain_name);
   }
 
   name get_ibc_contract_for_chain(name chain_name) {
-    switch (chain_name.value) {
-      case name("eos").value: {
-        return name("eosibc");
-      }
-      case name("wax").value: {
-        return name("waxibc");
-      }
-      default:
-        check(false, "no ibc contract for chain registered");
+    if (chain_name == current_chain_name()) {
+      return get_self();
     }
 
-    // make compiler happy
-    return name("");
+#ifdef REPORTERIBC_PROFILE_HEADER
+    for (const auto &peer : profile::peer_chains) {
+      if (peer.chain_name == chain_name) return peer.ibc_contract;
+    }
+#endif
+    return _chains_table
+        .get(chain_name.value, "no ibc contract for chain registered")
+        .ibc_contract;
   }
 
   uint32_t get_num_reporters() {
@@ -36,3 +36,12 @@ uint32_t count_non_empty(const std::vector<eosio::name>& vec) {
     }
     return count;
 }
+
+// log2 buckets: 0 holds 0s, bucket i holds [2^(i-1), 2^i) seconds and the
+// last bucket everything above, 20 buckets cover up to ~3 days
+static constexpr uint32_t LATENCY_BUCKETS = 20;
+
+uint32_t latency_bucket(uint32_t seconds) {
+    uint32_t bucket = seconds == 0 ? 0 : 32 - __builtin_clz(seconds);
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
@@ -1,15 +1,77 @@
 const { loadConfig, Blockchain } = require("@klevoya/hydra");
+const { createHash } = require("crypto");
 
 const config = loadConfig("hydra.yml");
 
+// eosio binary serialization of a transfer_s, for reports.arch digests
+const nameToUint64 = (name) => {
+  const charValue = (c) =>
+    c >= `a` && c <= `z`
+      ? c.charCodeAt(0) - 97 + 6
+      : c >= `1` && c <= `5`
+      ? c.charCodeAt(0) - 49 + 1
+      : 0;
+  let value = BigInt(0);
+  for (let i = 0; i < 13; i += 1) {
+    const c = i < name.length ? charValue(name[i]) : 0;
+    value |=
+      i < 12
+        ? BigInt(c & 0x1f) << BigInt(64 - 5 * (i + 1))
+        : BigInt(c & 0x0f);
+  }
+  return value;
+};
+const packTransfer = (t) => {
+  const buffer = Buffer.alloc(8 + 32 + 4 * 8 + 16 + 4 + 4 + 1);
+  let offset = 0;
+  const u64 = (value) => (offset = buffer.writeBigUInt64LE(value, offset));
+  const u32 = (value) => (offset = buffer.writeUInt32LE(value, offset));
+  const time = (iso) => u32(Date.parse(`${iso}Z`) / 1e3);
+
+  u64(BigInt(t.id));
+  offset += Buffer.from(t.transaction_id, `hex`).copy(buffer, offset);
+  [t.from_blockchain, t.to_blockchain, t.from_account, t.to_account].forEach(
+    (name) => u64(nameToUint64(name))
+  );
+  const [amount, code] = t.quantity.split(` `);
+  const precision = amount.split(`.`)[1].length;
+  u64(BigInt(amount.replace(`.`, ``)));
+  offset = buffer.writeUInt8(precision, offset);
+  offset += buffer.write(code.padEnd(7, `\0`), offset, `latin1`);
+  time(t.transaction_time);
+  time(t.expires_at);
+  buffer.writeUInt8(t.is_refund ? 1 : 0, offset);
+  return buffer;
+};
+const sha256 = (buffer) => createHash(`sha256`).update(buffer).digest(`hex`);
+
+// `account::name` of every action in a transaction trace, including inline
+// actions and notifications
+const actionsOf = (tx) => {
+  const traces = tx.processed ? tx.processed.action_traces : tx.action_traces;
+  const flatten = (trace) => [
+    `${trace.act.account}::${trace.act.name}`,
+    ...(trace.inline_traces || []).flatMap(flatten),
+  ];
+  return traces.flatMap(flatten);
+};
+
 const reporters = [`reporter1`, `reporter2`, `reporter3`];
 
+const balanceOf = (tokenAccount, account) => {
+  const rows = tokenAccount.getTableRowsScoped(`accounts`)[account];
+  return rows
+    ? BigInt(rows[0].balance.split(` `)[0].replace(`.`, ``))
+    : BigInt(0);
+};
+
 describe("reporteribc", () => {
   let blockchain = new Blockchain(config);
   let eosIbc = blockchain.createAccount(`eosibc`);
   let waxIbc = blockchain.createAccount(`waxibc`);
   let user1 = blockchain.createAccount(`user1`);
   let user1Wax = blockchain.createAccount(`user1onwax`);
+  let user2Wax = blockchain.createAccount(`user2onwax`);
   let token = blockchain.createAccount(`eosdt`);
   let wtoken = blockchain.createAccount(`weosdt`);
   reporters.forEach((r) => blockchain.createAccount(r));
@@ -42,14 +104,32 @@ describe("reporteribc", () => {
     //   ],
     // });
 
-    token.setContract(blockchain.contractTemplates[`eosio.token`]);
-    wtoken.setContract(blockchain.contractTemplates[`eosio.token`]);
-    await token.loadFixtures();
-    await wtoken.loadFixtures();
+    // the bundled eosio.token, it implements transfermany but no hydraload
+    token.setContract(blockchain.contractTemplates[`token`]);
+    wtoken.setContract(blockchain.contractTemplates[`token`]);
+    await token.contract.create({
+      issuer: token.accountName,
+      maximum_supply: `100000.123456789 EOSDT`,
+    });
+    await token.contract.issue({
+      to: token.accountName,
+      quantity: `1000.123456789 EOSDT`,
+      memo: ``,
+    });
+    await token.contract.transfer({
+      from: token.accountName,
+      to: user1.accountName,
+      quantity: `1000.123456789 EOSDT`,
+      memo: ``,
+    });
+    await wtoken.contract.create({
+      issuer: waxIbc.accountName,
+      maximum_supply: `100000.123456789 WEOSDT`,
+    });
   });
 
   it("can set everything up", async () => {
-    expect.assertions(3);
+    expect.assertions(4);
 
     await eosIbc.contract.init({
       current_chain_name: `eos`,
@@ -75,6 +155,20 @@ describe("reporteribc", () => {
       fees_percentage: 0.1,
       min_quantity: `1.133700000 WEOSDT`,
     });
+    await eosIbc.contract.setchain({
+      chain_name: `wax`,
+      ibc_contract: waxIbc.accountName,
+      min_quantity: `0.000000000 EOSDT`,
+      fees_percentage: null,
+      enabled: true,
+    });
+    await waxIbc.contract.setchain({
+      chain_name: `eos`,
+      ibc_contract: eosIbc.accountName,
+      min_quantity: `0.000000000 WEOSDT`,
+      fees_percentage: null,
+      enabled: true,
+    });
     for (const reporter of reporters) {
       await eosIbc.contract.addreporter({
         reporter,
@@ -115,6 +209,14 @@ describe("reporteribc", () => {
         total: "0.000000000 EOSDT",
       },
     ]);
+    expect(eosIbc.getTableRowsScoped(`chains`)[eosIbc.accountName]).toEqual([
+      expect.objectContaining({
+        chain_name: "wax",
+        ibc_contract: "waxibc",
+        min_quantity: "0.000000000 EOSDT",
+        enabled: true,
+      }),
+    ]);
     expect(eosIbc.getTableRowsScoped(`reporters`)[eosIbc.accountName]).toEqual([
       {
         account: "reporter1",
@@ -131,6 +233,25 @@ describe("reporteribc", () => {
     ]);
   });
 
+  it("rejects transfers to unregistered chains", async () => {
+    expect.assertions(1);
+
+    await expect(
+      token.contract.transfer(
+        {
+          from: user1.accountName,
+          to: eosIbc.accountName,
+          quantity: `10.000000000 EOSDT`,
+          memo: `bsc,user1onbsc`,
+        },
+        [{ actor: user1.accountName, permission: `active` }]
+      )
+    ).rejects.toHaveProperty(
+      "message",
+      expect.stringMatching(/target blockchain "bsc" is not valid/gi)
+    );
+  });
+
   it("can do a transfer, report", async () => {
     expect.assertions(4);
 
@@ -321,7 +442,7 @@ describe("reporteribc", () => {
       ...origTransferData,
       id: `0`,
       transaction_id: `B4D8617B13BC8FB2BF51324AB93E4684020C52C4BFEC0D6909B08B0F550486FD`,
-      from_account: waxIbc.accountName,
+      from_account: eosIbc.accountName,
       from_blockchain: origTransferData.to_blockchain,
       to_account: origTransferData.from_account,
       to_blockchain: origTransferData.from_blockchain,
@@ -329,4 +450,483 @@ describe("reporteribc", () => {
       is_refund: true,
     });
   });
+
+  it("keeps telemetry counters", async () => {
+    expect.assertions(4);
+
+    // a transfer that takes 100s to confirm and 300s to execute
+    await token.contract.transfer(
+      {
+        from: user1.accountName,
+        to: eosIbc.accountName,
+        quantity: `5.000000000 EOSDT`,
+        memo: `wax,user1onwax`,
+      },
+      [{ actor: user1.accountName, permission: `active` }]
+    );
+    const slowTransfer = eosIbc
+      .getTableRowsScoped(`transfers`)
+      [eosIbc.accountName].reverse()[0];
+    blockchain.setCurrentTime(new Date(`2000-01-01T00:01:40.000Z`));
+    for (const reporter of reporters.slice(0, 2)) {
+      await waxIbc.contract.report(
+        { reporter, transfer: slowTransfer },
+        [{ actor: reporter, permission: `active` }]
+      );
+    }
+    blockchain.setCurrentTime(new Date(`2000-01-01T00:05:00.000Z`));
+    const slowReport = waxIbc
+      .getTableRowsScoped(`reports`)
+      [waxIbc.accountName].reverse()[0];
+    await waxIbc.contract.exec(
+      { reporter: reporters[0], report_id: slowReport.id },
+      [{ actor: reporters[0], permission: `active` }]
+    );
+
+    // the first transfers expired on 2000-01-02, the next report evicts the
+    // refund transfer and two reports and archives the unprocessed one
+    blockchain.setCurrentTime(new Date(`2000-01-02T00:10:00.000Z`));
+    await token.contract.transfer(
+      {
+        from: user1.accountName,
+        to: eosIbc.accountName,
+        quantity: `5.000000000 EOSDT`,
+        memo: `wax,user1onwax`,
+      },
+      [{ actor: user1.accountName, permission: `active` }]
+    );
+    await waxIbc.contract.report(
+      {
+        reporter: reporters[0],
+        transfer: eosIbc
+          .getTableRowsScoped(`transfers`)
+          [eosIbc.accountName].reverse()[0],
+      },
+      [{ actor: reporters[0], permission: `active` }]
+    );
+
+    expect(eosIbc.getTableRowsScoped(`telemetry`)[eosIbc.accountName]).toEqual([
+      expect.objectContaining({
+        transfers_registered: "4",
+        refunds: "0",
+      }),
+    ]);
+
+    const telemetry = waxIbc.getTableRowsScoped(`telemetry`)[
+      waxIbc.accountName
+    ][0];
+    expect(telemetry).toMatchObject({
+      transfers_registered: "1",
+      reports_created: "5",
+      reports_confirmed: "3",
+      executions: "2",
+      failures: "1",
+      refunds: "1",
+      evicted: "3",
+      expired: "1",
+    });
+    // 0s for the transfers settled at 2000-01-01T00:00, 100s falls into the
+    // [64, 128) bucket, 300s into [256, 512)
+    expect([
+      telemetry.confirm_latency[0],
+      telemetry.confirm_latency[7],
+    ]).toEqual([2, 1]);
+    expect([telemetry.exec_latency[0], telemetry.exec_latency[9]]).toEqual([
+      1,
+      1,
+    ]);
+  });
+
+  it("archives expired reports and purges / exports the archive", async () => {
+    expect.assertions(10);
+
+    const archiveRows = () =>
+      waxIbc.getTableRowsScoped(`reports.arch`)[waxIbc.accountName];
+
+    // the report of the tampered transfer expired unprocessed
+    const tampered = {
+      ...eosIbc.getTableRowsScoped(`transfers`)[eosIbc.accountName][0],
+      to_account: `eosdt`,
+    };
+    const [archived] = archiveRows();
+    expect(archived).toEqual({
+      id: "0",
+      report_id: "0",
+      transfer_digest: expect.any(String),
+      transfer_id: "0",
+      from_blockchain: "eos",
+      from_account: "user1",
+      to_account: "eosdt",
+      quantity: "9.000000000 EOSDT",
+      expires_at: "2000-01-02T00:00:00.000",
+      is_refund: false,
+      // only reporter1, the first reporter by account
+      confirmed_mask: "1",
+    });
+    expect(archived.transfer_digest.toLowerCase()).toEqual(
+      sha256(packTransfer(tampered))
+    );
+
+    const depositAndReport = async (reporterList) => {
+      await token.contract.transfer(
+        {
+          from: user1.accountName,
+          to: eosIbc.accountName,
+          quantity: `5.000000000 EOSDT`,
+          memo: `wax,user1onwax`,
+        },
+        [{ actor: user1.accountName, permission: `active` }]
+      );
+      const transfer = eosIbc
+        .getTableRowsScoped(`transfers`)
+        [eosIbc.accountName].reverse()[0];
+      for (const reporter of reporterList) {
+        await waxIbc.contract.report(
+          { reporter, transfer },
+          [{ actor: reporter, permission: `active` }]
+        );
+      }
+    };
+
+    // unconfirmed reports expiring one hour apart
+    for (const hour of [1, 2, 3]) {
+      blockchain.setCurrentTime(new Date(`2000-01-02T0${hour}:00:00.000Z`));
+      await depositAndReport([reporters[0]]);
+    }
+    // every report evicts up to two expired reports
+    blockchain.setCurrentTime(new Date(`2000-01-03T03:30:00.000Z`));
+    await depositAndReport(reporters.slice(0, 2));
+
+    expect(archiveRows().map((a) => [a.id, a.expires_at])).toEqual([
+      ["0", "2000-01-02T00:00:00.000"],
+      ["1", "2000-01-03T00:10:00.000"],
+      ["2", "2000-01-03T01:00:00.000"],
+      ["3", "2000-01-03T02:00:00.000"],
+      ["4", "2000-01-03T03:00:00.000"],
+    ]);
+
+    await expect(
+      waxIbc.contract[`arch.purge`](
+        { before: "2000-01-03T01:00:00.000", max_rows: 10 },
+        [{ actor: reporters[0], permission: `active` }]
+      )
+    ).rejects.toBeTruthy();
+
+    // max_rows limits the purge
+    await waxIbc.contract[`arch.purge`]({
+      before: "2000-01-03T01:00:00.000",
+      max_rows: 1,
+    });
+    expect(archiveRows().map((a) => a.id)).toEqual(["1", "2", "3", "4"]);
+    // rows expiring exactly at `before` are kept
+    await waxIbc.contract[`arch.purge`]({
+      before: "2000-01-03T01:00:00.000",
+      max_rows: 10,
+    });
+    expect(archiveRows().map((a) => a.id)).toEqual(["2", "3", "4"]);
+
+    // export pages by id and only erases when asked to
+    await waxIbc.contract[`arch.export`]({ from_id: 3, limit: 1, erase: true });
+    expect(archiveRows().map((a) => a.id)).toEqual(["2", "4"]);
+    await waxIbc.contract[`arch.export`]({
+      from_id: 0,
+      limit: 10,
+      erase: false,
+    });
+    expect(archiveRows().map((a) => a.id)).toEqual(["2", "4"]);
+    await waxIbc.contract[`arch.export`]({ from_id: 0, limit: 1, erase: true });
+    expect(archiveRows().map((a) => a.id)).toEqual(["4"]);
+    await waxIbc.contract[`arch.export`]({ from_id: 0, limit: 10, erase: true });
+    expect(archiveRows()).toBeUndefined();
+  });
+
+  it("debits transfermany once and credits every output", async () => {
+    expect.assertions(3);
+
+    const before = [user1.accountName, reporters[0], reporters[1]].map(
+      (account) => balanceOf(token, account)
+    );
+    await token.contract.transfermany(
+      {
+        from: user1.accountName,
+        outputs: [
+          { first: reporters[0], second: `1.000000000 EOSDT` },
+          { first: reporters[1], second: `2.000000000 EOSDT` },
+        ],
+        memo: ``,
+      },
+      [{ actor: user1.accountName, permission: `active` }]
+    );
+
+    expect(balanceOf(token, user1.accountName)).toEqual(
+      before[0] - BigInt(3e9)
+    );
+    expect(balanceOf(token, reporters[0])).toEqual(before[1] + BigInt(1e9));
+    expect(balanceOf(token, reporters[1])).toEqual(before[2] + BigInt(2e9));
+  });
+
+  it("rejects transfermany outputs to the bridge", async () => {
+    expect.assertions(2);
+
+    const before = balanceOf(token, user1.accountName);
+    // the bridge is notified as a recipient and aborts the whole action
+    await expect(
+      token.contract.transfermany(
+        {
+          from: user1.accountName,
+          outputs: [
+            { first: reporters[0], second: `1.000000000 EOSDT` },
+            { first: eosIbc.accountName, second: `5.000000000 EOSDT` },
+          ],
+          memo: `wax,user1onwax`,
+        },
+        [{ actor: user1.accountName, permission: `active` }]
+      )
+    ).rejects.toHaveProperty(
+      "message",
+      expect.stringMatching(/deposits must use transfer/gi)
+    );
+    expect(balanceOf(token, user1.accountName)).toEqual(before);
+  });
+
+  it("executes several reports with one batched payout", async () => {
+    expect.assertions(4);
+
+    await waxIbc.contract.setbatchpay({ enable: true });
+
+    const reportIds = [];
+    for (const toAccount of [user1Wax.accountName, user2Wax.accountName]) {
+      await token.contract.transfer(
+        {
+          from: user1.accountName,
+          to: eosIbc.accountName,
+          quantity: `6.000000000 EOSDT`,
+          memo: `wax,${toAccount}`,
+        },
+        [{ actor: user1.accountName, permission: `active` }]
+      );
+      const transfer = eosIbc
+        .getTableRowsScoped(`transfers`)
+        [eosIbc.accountName].reverse()[0];
+      for (const reporter of reporters.slice(0, 2)) {
+        await waxIbc.contract.report(
+          { reporter, transfer },
+          [{ actor: reporter, permission: `active` }]
+        );
+      }
+      reportIds.push(
+        waxIbc.getTableRowsScoped(`reports`)[waxIbc.accountName].reverse()[0]
+          .id
+      );
+    }
+
+    const before = [user1Wax.accountName, user2Wax.accountName].map(
+      (account) => balanceOf(wtoken, account)
+    );
+    const executionsBefore = BigInt(
+      waxIbc.getTableRowsScoped(`telemetry`)[waxIbc.accountName][0].executions
+    );
+    await waxIbc.contract.execmany(
+      { reporter: reporters[2], report_ids: reportIds },
+      [{ actor: reporters[2], permission: `active` }]
+    );
+
+    expect(
+      waxIbc
+        .getTableRowsScoped(`reports`)
+        [waxIbc.accountName].filter((r) => reportIds.includes(r.id))
+        .map((r) => r.executed)
+    ).toEqual([true, true]);
+    // 6 EOSDT minus 10% fees each
+    expect(balanceOf(wtoken, user1Wax.accountName)).toEqual(
+      before[0] + BigInt(5.4e9)
+    );
+    expect(balanceOf(wtoken, user2Wax.accountName)).toEqual(
+      before[1] + BigInt(5.4e9)
+    );
+    expect(
+      BigInt(
+        waxIbc.getTableRowsScoped(`telemetry`)[waxIbc.accountName][0]
+          .executions
+      )
+    ).toEqual(executionsBefore + BigInt(2));
+  });
+
+  it("issues fees to the reporters with one batched payout", async () => {
+    expect.assertions(4);
+
+    await eosIbc.contract.setbatchpay({ enable: true });
+
+    // 11 transfers reported by all three reporters earn 33 points, enough for
+    // a distribution with a threshold of 2
+    for (let id = 0; id < 11; id += 1) {
+      const transfer = {
+        id: `${id}`,
+        transaction_id: `${id}`.padStart(64, `0`),
+        from_blockchain: `wax`,
+        to_blockchain: `eos`,
+        from_account: `user1onwax`,
+        to_account: `user1`,
+        quantity: `1.000000000 WEOSDT`,
+        transaction_time: `2000-01-03T03:30:00.000`,
+        expires_at: `2000-01-04T03:30:00.000`,
+        is_refund: false,
+      };
+      for (const reporter of reporters) {
+        await eosIbc.contract.report(
+          { reporter, transfer },
+          [{ actor: reporter, permission: `active` }]
+        );
+      }
+    }
+
+    const fees = () => eosIbc.getTableRowsScoped(`fees`)[eosIbc.accountName][0];
+    const reserveAmount = (row) =>
+      BigInt(row.reserve.split(` `)[0].replace(`.`, ``));
+    const reserveBefore = reserveAmount(fees());
+    const accounts = [eosIbc.accountName, ...reporters];
+    const before = accounts.map((account) => balanceOf(token, account));
+
+    await eosIbc.contract.issuefees({});
+
+    const deltas = accounts.map(
+      (account, index) => balanceOf(token, account) - before[index]
+    );
+    // equal points, equal shares
+    const share = deltas[1];
+    expect(share > BigInt(0) && deltas.slice(1).every((d) => d === share)).toBe(
+      true
+    );
+    expect(deltas[0]).toEqual(-share * BigInt(3));
+    expect(reserveAmount(fees())).toEqual(reserveBefore - share * BigInt(3));
+    expect(
+      eosIbc
+        .getTableRowsScoped(`reporters`)
+        [eosIbc.accountName].map((r) => r.points)
+    ).toEqual([`0`, `0`, `0`]);
+  });
+
+  it("rejects reports of transfers not addressed from a peer to this chain", async () => {
+    expect.assertions(2);
+
+    const transfer = {
+      id: `100`,
+      transaction_id: `${100}`.padStart(64, `0`),
+      from_blockchain: `wax`,
+      to_blockchain: `eos`,
+      from_account: `user1onwax`,
+      to_account: `user1`,
+      quantity: `1.000000000 WEOSDT`,
+      transaction_time: `2000-01-03T03:30:00.000`,
+      expires_at: `2000-01-04T03:30:00.000`,
+      is_refund: false,
+    };
+
+    await expect(
+      waxIbc.contract.report(
+        { reporter: reporters[0], transfer },
+        [{ actor: reporters[0], permission: `active` }]
+      )
+    ).rejects.toHaveProperty(
+      "message",
+      expect.stringMatching(/not addressed to this chain/gi)
+    );
+    await expect(
+      eosIbc.contract.report(
+        {
+          reporter: reporters[0],
+          transfer: { ...transfer, from_blockchain: `bsc` },
+        },
+        [{ actor: reporters[0], permission: `active` }]
+      )
+    ).rejects.toHaveProperty(
+      "message",
+      expect.stringMatching(/not from a registered chain/gi)
+    );
+  });
+
+  it("emits event actions for every state change", async () => {
+    expect.assertions(6);
+
+    const deposit = async () => {
+      const tx = await token.contract.transfer(
+        {
+          from: user1.accountName,
+          to: eosIbc.accountName,
+          quantity: `5.000000000 EOSDT`,
+          memo: `wax,user1onwax`,
+        },
+        [{ actor: user1.accountName, permission: `active` }]
+      );
+      const transfer = eosIbc
+        .getTableRowsScoped(`transfers`)
+        [eosIbc.accountName].reverse()[0];
+      return { tx, transfer };
+    };
+    // the transaction of the confirming report
+    const confirm = async (transfer) => {
+      let tx;
+      for (const reporter of reporters.slice(0, 2)) {
+        tx = await waxIbc.contract.report(
+          { reporter, transfer },
+          [{ actor: reporter, permission: `active` }]
+        );
+      }
+      return tx;
+    };
+    const lastReportId = () =>
+      waxIbc.getTableRowsScoped(`reports`)[waxIbc.accountName].reverse()[0].id;
+
+    const executed = await deposit();
+    expect(actionsOf(executed.tx)).toContain(`eosibc::evtransfer`);
+    expect(actionsOf(await confirm(executed.transfer))).toContain(
+      `waxibc::evconfirm`
+    );
+    const execTx = await waxIbc.contract.exec(
+      { reporter: reporters[2], report_id: lastReportId() },
+      [{ actor: reporters[2], permission: `active` }]
+    );
+    expect(actionsOf(execTx)).toContain(`waxibc::evexec`);
+
+    const failed = await deposit();
+    await confirm(failed.transfer);
+    const reportId = lastReportId();
+    let failTx;
+    for (const reporter of reporters.slice(0, 2)) {
+      failTx = await waxIbc.contract.execfailed(
+        { reporter, report_id: reportId },
+        [{ actor: reporter, permission: `active` }]
+      );
+    }
+    // the refund is registered as a new transfer
+    expect(actionsOf(failTx)).toEqual(
+      expect.arrayContaining([`waxibc::evfailed`, `waxibc::evtransfer`])
+    );
+
+    // only the contract itself can log events
+    await expect(
+      waxIbc.contract.evconfirm(
+        {
+          event: {
+            report_id: reportId,
+            from_blockchain: `eos`,
+            transfer_id: failed.transfer.id,
+          },
+        },
+        [{ actor: reporters[0], permission: `active` }]
+      )
+    ).rejects.toHaveProperty(
+      "message",
+      expect.stringMatching(/missing authority of waxibc/gi)
+    );
+    await expect(
+      eosIbc.contract.evtransfer(
+        { transfer: failed.transfer },
+        [{ actor: user1.accountName, permission: `active` }]
+      )
+    ).rejects.toHaveProperty(
+      "message",
+      expect.stringMatching(/missing authority of eosibc/gi)
+    );
+  });
 });
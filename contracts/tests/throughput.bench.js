@@ -0,0 +1,466 @@
+const { loadConfig, Blockchain } = require("@klevoya/hydra");
+const { writeFileSync } = require("fs");
+
+// End-to-end throughput benchmark: deposits into `eosibc` (source chain)
+// are reported and executed on `waxibc` (destination chain) by simulated
+// reporters that select and submit rows like reporter/src/reporter.ts.
+// Run with `npm run bench`, tune with the BENCH_* environment variables.
+const envInt = (name, fallback) =>
+  Number.parseInt(process.env[name] || `${fallback}`, 10);
+
+const BENCH = {
+  config: process.env.BENCH_HYDRA_CONFIG || `hydra.yml`,
+  // contract template deployed to `waxibc`, e.g. a profile build
+  destinationTemplate: process.env.BENCH_DEST_TEMPLATE || `reporteribc`,
+  transfers: envInt(`BENCH_TRANSFERS`, 200),
+  // deposits per second pushed into the source contract
+  rate: envInt(`BENCH_RATE`, 20),
+  reporters: envInt(`BENCH_REPORTERS`, 3),
+  threshold: envInt(`BENCH_THRESHOLD`, 2),
+  pollMs: envInt(`BENCH_POLL_MS`, 100),
+  // the reporter's MAX_IN_FLIGHT, MAX_ACTIONS_PER_TX and settle time
+  window: envInt(`BENCH_WINDOW`, 8),
+  batchSize: envInt(`BENCH_BATCH_SIZE`, 10),
+  settleMs: envInt(`BENCH_SETTLE_MS`, 60 * 1e3),
+  sampleMs: envInt(`BENCH_SAMPLE_MS`, 1000),
+  timeoutMs: envInt(`BENCH_TIMEOUT_MS`, 10 * 60 * 1e3),
+  out: process.env.BENCH_OUT,
+};
+
+const DEPOSIT_QUANTITY = `1.200000000 EOSDT`;
+const STAGES = [`register`, `first_report`, `confirm`, `exec`];
+
+const config = loadConfig(BENCH.config);
+
+const sleep = (ms) => new Promise((resolve) => setTimeout(resolve, ms));
+
+const percentile = (sorted, p) => {
+  if (sorted.length === 0) return NaN;
+  const index = Math.min(
+    sorted.length - 1,
+    Math.max(0, Math.ceil((p / 100) * sorted.length) - 1)
+  );
+  return sorted[index];
+};
+
+const summarize = (values) => {
+  const sorted = [...values].sort((a, b) => a - b);
+  return {
+    count: sorted.length,
+    p50: percentile(sorted, 50),
+    p99: percentile(sorted, 99),
+    max: sorted[sorted.length - 1],
+  };
+};
+
+// eosio names only allow a-z1-5
+const reporterName = (index) => {
+  const alphabet = `abcdefghijklmnopqrstuvwxyz12345`;
+  let suffix = ``;
+  do {
+    suffix = alphabet[index % alphabet.length] + suffix;
+    index = Math.floor(index / alphabet.length);
+  } while (index > 0);
+  return `benchrep${suffix}`;
+};
+
+const transferKey = (t) => `${t.from_blockchain}|${t.id}|${t.transaction_id}`;
+
+const classifyError = (error) => {
+  const message = `${(error && error.message) || error}`;
+  if (/already reported|already executed|already failed/i.test(message))
+    return `duplicate`;
+  return `failed`;
+};
+
+class Stats {
+  constructor() {
+    // transfer key => { stage => ms since deposit was submitted }
+    this.timings = {};
+    this.depositStart = {};
+    this.actions = {};
+    // action name => batches submitted, transactions of the real reporter
+    this.batches = {};
+    // action name => ms per successful push, a proxy for its CPU cost
+    this.durations = {};
+    this.samples = [];
+    this.startedAt = Date.now();
+  }
+
+  action(name, outcome, ms) {
+    if (!this.actions[name])
+      this.actions[name] = { ok: 0, duplicate: 0, failed: 0 };
+    this.actions[name][outcome] += 1;
+    if (outcome !== `ok`) return;
+    if (!this.durations[name]) this.durations[name] = [];
+    this.durations[name].push(ms);
+  }
+
+  batch(name) {
+    this.batches[name] = (this.batches[name] || 0) + 1;
+  }
+
+  stage(key, stage) {
+    if (this.depositStart[key] === undefined) return;
+    if (!this.timings[key]) this.timings[key] = {};
+    if (this.timings[key][stage] !== undefined) return;
+    this.timings[key][stage] = Date.now() - this.depositStart[key];
+  }
+
+  executedCount() {
+    return Object.values(this.timings).filter((t) => t.exec !== undefined)
+      .length;
+  }
+
+  report() {
+    const elapsedSec = (Date.now() - this.startedAt) / 1e3;
+    const latencies = STAGES.reduce((acc, stage) => {
+      acc[stage] = summarize(
+        Object.values(this.timings)
+          .map((t) => t[stage])
+          .filter((ms) => ms !== undefined)
+      );
+      return acc;
+    }, {});
+    const actions = Object.keys(this.actions).reduce((acc, name) => {
+      const { ok, duplicate, failed } = this.actions[name];
+      const total = ok + duplicate + failed;
+      acc[name] = {
+        ok,
+        duplicate,
+        failed,
+        duplicateRatio: total ? duplicate / total : 0,
+        failedRatio: total ? failed / total : 0,
+        durationMs: summarize(this.durations[name] || []),
+      };
+      return acc;
+    }, {});
+
+    return {
+      settings: BENCH,
+      elapsedSec,
+      executed: this.executedCount(),
+      throughputPerSec: this.executedCount() / elapsedSec,
+      latencyMs: latencies,
+      actions,
+      batches: this.batches,
+      ram: this.samples,
+    };
+  }
+}
+
+// the submission strategy of reporter/src/utils/pipeline.ts: every poll
+// replaces the queue with all actionable rows, rows in flight or submitted
+// within settleMs are skipped and up to `window` batches of `batchSize`
+// actions are in flight at once. Hydra applies actions one at a time, so a
+// failing action does not revert the rest of its batch and the bisecting of
+// failed batches is not modeled.
+class SimulatedPipeline {
+  constructor(key, submit) {
+    this.key = key;
+    this.submit = submit;
+    this.queue = [];
+    this.inFlight = new Set();
+    this.inFlightCount = 0;
+    this.settled = new Map();
+    this.running = new Set();
+  }
+
+  enqueue(items) {
+    const now = Date.now();
+    for (const [key, at] of this.settled) {
+      if (now - at > BENCH.settleMs) this.settled.delete(key);
+    }
+    this.queue = items.filter((item) => {
+      const key = this.key(item);
+      return !this.inFlight.has(key) && !this.settled.has(key);
+    });
+    this.pump();
+  }
+
+  pump() {
+    while (this.inFlightCount < BENCH.window && this.queue.length > 0) {
+      const run = this.run(this.queue.splice(0, BENCH.batchSize));
+      this.running.add(run);
+      run.then(() => this.running.delete(run));
+    }
+  }
+
+  async run(batch) {
+    const keys = batch.map(this.key);
+    keys.forEach((key) => this.inFlight.add(key));
+    this.inFlightCount += 1;
+    try {
+      await this.submit(batch);
+    } finally {
+      const now = Date.now();
+      keys.forEach((key) => {
+        this.inFlight.delete(key);
+        this.settled.set(key, now);
+      });
+      this.inFlightCount -= 1;
+      this.pump();
+    }
+  }
+
+  async drain() {
+    this.queue = [];
+    while (this.running.size > 0) await Promise.all([...this.running]);
+  }
+}
+
+// mirrors Reporter.reportTransfers / Reporter.executeReports against the
+// local contracts, without the irreversibility wait (hydra has no forks)
+class SimulatedReporter {
+  constructor(account, source, destination, stats) {
+    this.account = account;
+    this.source = source;
+    this.destination = destination;
+    this.stats = stats;
+    this.running = false;
+    this.reportPipeline = new SimulatedPipeline(transferKey, (transfers) =>
+      this.submitReports(transfers)
+    );
+    this.execPipeline = new SimulatedPipeline(
+      (report) => report.id,
+      (reports) => this.submitExecs(reports)
+    );
+  }
+
+  async start() {
+    this.running = true;
+    while (this.running) {
+      this.reportTransfers();
+      this.executeReports();
+      await sleep(BENCH.pollMs);
+    }
+    await Promise.all([this.reportPipeline.drain(), this.execPipeline.drain()]);
+  }
+
+  stop() {
+    this.running = false;
+  }
+
+  rows(account, table) {
+    return account.getTableRowsScoped(table)[account.accountName] || [];
+  }
+
+  shuffle(array) {
+    const copy = [...array];
+    for (let i = copy.length - 1; i > 0; i -= 1) {
+      const j = Math.floor(Math.random() * (i + 1));
+      [copy[i], copy[j]] = [copy[j], copy[i]];
+    }
+    return copy;
+  }
+
+  reportTransfers() {
+    const reported = new Set(
+      this.rows(this.destination, `reports`)
+        .filter((r) => r.confirmed_by.includes(this.account))
+        .map((r) => transferKey(r.transfer))
+    );
+    this.reportPipeline.enqueue(
+      this.rows(this.source, `transfers`).filter(
+        (t) => !reported.has(transferKey(t))
+      )
+    );
+  }
+
+  executeReports() {
+    // different order for every reporter to avoid executing the same report
+    this.execPipeline.enqueue(
+      this.shuffle(
+        this.rows(this.destination, `reports`).filter(
+          (r) =>
+            r.confirmed &&
+            !r.executed &&
+            !r.failed &&
+            !r.failed_by.includes(this.account)
+        )
+      )
+    );
+  }
+
+  async submitReports(transfers) {
+    this.stats.batch(`report`);
+    for (const transfer of transfers) {
+      const start = Date.now();
+      try {
+        await this.destination.contract.report(
+          { reporter: this.account, transfer },
+          [{ actor: this.account, permission: `active` }]
+        );
+        this.stats.action(`report`, `ok`, Date.now() - start);
+        const key = transferKey(transfer);
+        this.stats.stage(key, `first_report`);
+        const report = this.rows(this.destination, `reports`).find(
+          (r) => transferKey(r.transfer) === key && r.confirmed
+        );
+        if (report) this.stats.stage(key, `confirm`);
+      } catch (error) {
+        this.stats.action(`report`, classifyError(error));
+      }
+    }
+  }
+
+  async submitExecs(reports) {
+    this.stats.batch(`exec`);
+    for (const report of reports) {
+      const start = Date.now();
+      try {
+        await this.destination.contract.exec(
+          { reporter: this.account, report_id: report.id },
+          [{ actor: this.account, permission: `active` }]
+        );
+        this.stats.action(`exec`, `ok`, Date.now() - start);
+        this.stats.stage(transferKey(report.transfer), `exec`);
+      } catch (error) {
+        this.stats.action(`exec`, classifyError(error));
+      }
+    }
+  }
+}
+
+describe("reporteribc throughput", () => {
+  let blockchain = new Blockchain(config);
+  let eosIbc = blockchain.createAccount(`eosibc`);
+  let waxIbc = blockchain.createAccount(`waxibc`);
+  let user1 = blockchain.createAccount(`user1`);
+  blockchain.createAccount(`user1onwax`);
+  let token = blockchain.createAccount(`eosdt`);
+  let wtoken = blockchain.createAccount(`weosdt`);
+  const reporters = Array.from({ length: BENCH.reporters }, (_, i) =>
+    reporterName(i)
+  );
+  reporters.forEach((r) => blockchain.createAccount(r));
+
+  beforeAll(async () => {
+    [
+      [eosIbc, `reporteribc`],
+      [waxIbc, BENCH.destinationTemplate],
+    ].forEach(([acc, template]) => {
+      acc.setContract(blockchain.contractTemplates[template]);
+      acc.updateAuth(`active`, `owner`, {
+        accounts: [
+          {
+            permission: {
+              actor: acc.accountName,
+              permission: `eosio.code`,
+            },
+            weight: 1,
+          },
+        ],
+      });
+    });
+    token.setContract(blockchain.contractTemplates[`eosio.token`]);
+    wtoken.setContract(blockchain.contractTemplates[`eosio.token`]);
+    await token.loadFixtures();
+    await wtoken.loadFixtures();
+
+    for (const [ibc, chain, symbol, tokenAccount, doIssue, peer] of [
+      [eosIbc, `eos`, `EOSDT`, token, false, waxIbc],
+      [waxIbc, `wax`, `WEOSDT`, wtoken, true, eosIbc],
+    ]) {
+      await ibc.contract.init({
+        current_chain_name: chain,
+        token_info: {
+          symbol: `9,${symbol}`,
+          contract: tokenAccount.accountName,
+        },
+        expire_after_seconds: 86400,
+        do_issue: doIssue,
+        threshold: BENCH.threshold,
+        fees_percentage: 0.002,
+        min_quantity: `1.000000000 ${symbol}`,
+      });
+      await ibc.contract.setchain({
+        chain_name: chain === `eos` ? `wax` : `eos`,
+        ibc_contract: peer.accountName,
+        min_quantity: `0.000000000 ${symbol}`,
+        fees_percentage: null,
+        enabled: true,
+      });
+      for (const reporter of reporters) {
+        await ibc.contract.addreporter({ reporter });
+      }
+      await ibc.contract.enable({ enable: true });
+    }
+  });
+
+  it(
+    "settles deposits from eos to wax",
+    async () => {
+      const stats = new Stats();
+      const simulated = reporters.map(
+        (r) => new SimulatedReporter(r, eosIbc, waxIbc, stats)
+      );
+      const running = simulated.map((r) => r.start());
+
+      const sampler = setInterval(() => {
+        const sample = { atSec: (Date.now() - stats.startedAt) / 1e3 };
+        for (const [account, table] of [
+          [eosIbc, `transfers`],
+          [waxIbc, `reports`],
+          [waxIbc, `reports.arch`],
+        ]) {
+          const rows =
+            account.getTableRowsScoped(table)[account.accountName] || [];
+          // hydra does not expose account RAM usage, JSON size is a proxy
+          sample[`${account.accountName}.${table}`] = {
+            rows: rows.length,
+            jsonBytes: JSON.stringify(rows).length,
+          };
+        }
+        stats.samples.push(sample);
+      }, BENCH.sampleMs);
+
+      // sequential deposits paced at BENCH.rate so every new transfer row
+      // can be attributed to the deposit that created it
+      const interval = 1e3 / BENCH.rate;
+      for (let i = 0; i < BENCH.transfers; i += 1) {
+        const slot = stats.startedAt + i * interval;
+        if (Date.now() < slot) await sleep(slot - Date.now());
+
+        const submittedAt = Date.now();
+        try {
+          await token.contract.transfer(
+            {
+              from: user1.accountName,
+              to: eosIbc.accountName,
+              quantity: DEPOSIT_QUANTITY,
+              memo: `wax,user1onwax`,
+            },
+            [{ actor: user1.accountName, permission: `active` }]
+          );
+          stats.action(`deposit`, `ok`, Date.now() - submittedAt);
+        } catch (error) {
+          stats.action(`deposit`, classifyError(error));
+          continue;
+        }
+        const transfers =
+          eosIbc.getTableRowsScoped(`transfers`)[eosIbc.accountName];
+        const key = transferKey(transfers[transfers.length - 1]);
+        stats.depositStart[key] = submittedAt;
+        stats.stage(key, `register`);
+      }
+
+      const deposited = stats.actions.deposit ? stats.actions.deposit.ok : 0;
+      const deadline = stats.startedAt + BENCH.timeoutMs;
+      while (stats.executedCount() < deposited && Date.now() < deadline) {
+        await sleep(BENCH.pollMs);
+      }
+
+      simulated.forEach((r) => r.stop());
+      await Promise.all(running);
+      clearInterval(sampler);
+
+      const result = stats.report();
+      console.log(JSON.stringify(result, null, 2));
+      if (BENCH.out) writeFileSync(BENCH.out, JSON.stringify(result, null, 2));
+
+      expect(result.executed).toEqual(deposited);
+    },
+    BENCH.timeoutMs + 60 * 1e3
+  );
+});
@@ -0,0 +1,13 @@
+import { NextFunction, Request, Response } from "express";
+import { renderMetrics } from "../utils/metrics";
+
+export default class MetricsController {
+  async metrics(request: Request, response: Response, next: NextFunction) {
+    try {
+      response.set(`Content-Type`, `text/plain; version=0.0.4`);
+      return renderMetrics();
+    } catch (err) {
+      next(err);
+    }
+  }
+}
@@ -2,7 +2,7 @@ import { NetworkName } from "../types";
 import { Api } from "eosjs";
 import { JsSignatureProvider } from "eosjs/dist/eosjs-jssig";
 import { TextDecoder, TextEncoder } from "util";
-import { getRpc } from "./networks";
+import { getNetwork, getRpc } from "./networks";
 import { logger } from "../logger";
 import { getEnvConfig } from "../dotenv";
 import { isProduction, unmapNetworkName } from "../utils";
@@ -24,6 +24,8 @@ export const getApi: (networkName: string) => Api = (() => {
       ].filter(Boolean));
       apis[_networkName] = new Api({
         rpc: getRpc(networkName),
+        // known chain id, eosjs would otherwise call get_info to look it up
+        chainId: getNetwork(_networkName).chainId,
         signatureProvider,
         textDecoder: new TextDecoder(),
         textEncoder: new TextEncoder() as any,
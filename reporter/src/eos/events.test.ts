@@ -0,0 +1,98 @@
+import fs from "fs";
+import os from "os";
+import path from "path";
+import {
+  EventLog,
+  FileTraceSource,
+  MemoryTraceSource,
+  TActionTraceRecord,
+} from "./events";
+
+jest.mock("../logger", () => ({
+  logger: { warn: jest.fn(), info: jest.fn(), log: jest.fn() },
+}));
+
+const trace = (
+  sequence: number,
+  name = `evconfirm`,
+  account = `eosibc`
+): TActionTraceRecord => ({
+  receipt: { global_sequence: `${sequence}` },
+  act: {
+    account,
+    name,
+    data: {
+      event: { report_id: sequence, from_blockchain: `wax`, transfer_id: 0 },
+    },
+  },
+});
+const reportIds = (events: any[]) => events.map((e) => e.data.event.report_id);
+
+describe("EventLog", () => {
+  it("hands out each event once, ordered by global_sequence", async () => {
+    const source = new MemoryTraceSource();
+    const log = new EventLog(`eosibc`, source);
+
+    source.push(
+      trace(12),
+      trace(10),
+      trace(11, `transfer`),
+      trace(13, `evconfirm`, `othercontract`),
+      trace(10)
+    );
+    expect(reportIds(await log.poll())).toEqual([10, 12]);
+
+    // a history consumer re-delivering traces after a reconnect
+    source.push(trace(12), trace(9), trace(14, `evexec`));
+    const events = await log.poll();
+    expect(events.map((e) => e.name)).toEqual([`evexec`]);
+    expect(reportIds(events)).toEqual([14]);
+  });
+
+  it("resumes from a checkpoint without repeating events", async () => {
+    const source = new MemoryTraceSource();
+    const log = new EventLog(`eosibc`, source);
+    source.push(trace(1), trace(2));
+    await log.poll();
+
+    const resumedSource = new MemoryTraceSource();
+    const restored = new EventLog(`eosibc`, resumedSource);
+    restored.restore(log.checkpoint());
+    expect(restored.checkpoint()).toEqual({ position: 2, sequence: 2 });
+
+    resumedSource.push(trace(2), trace(3));
+    expect(reportIds(await restored.poll())).toEqual([3]);
+  });
+});
+
+describe("FileTraceSource", () => {
+  let dir: string;
+
+  beforeEach(() => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), `traces-`));
+  });
+  afterEach(() => {
+    fs.readdirSync(dir).forEach((file) => fs.unlinkSync(path.join(dir, file)));
+    fs.rmdirSync(dir);
+  });
+
+  it("skips corrupt lines and waits for a line to be completed", async () => {
+    const file = path.join(dir, `eos.jsonl`);
+    const lines = [
+      JSON.stringify(trace(1)),
+      `{"receipt":`,
+      JSON.stringify(trace(2)),
+    ];
+    const partial = JSON.stringify(trace(3));
+    fs.writeFileSync(file, `${lines.join(`\n`)}\n${partial.slice(0, 10)}`);
+
+    const source = new FileTraceSource(file);
+    const log = new EventLog(`eosibc`, source);
+    expect(reportIds(await log.poll())).toEqual([1, 2]);
+    expect(source.position).toEqual(lines.join(`\n`).length + 1);
+
+    fs.appendFileSync(file, `${partial.slice(10)}\n`);
+    expect(reportIds(await log.poll())).toEqual([3]);
+    expect(await log.poll()).toEqual([]);
+  });
+});
@@ -0,0 +1,178 @@
+import fs from "fs";
+import { promisify } from "util";
+import { NetworkName, TTransfersRow } from "../types";
+import { unmapNetworkName } from "../utils";
+import { logger } from "../logger";
+
+// the ibc contract logs state changes through no-op inline actions
+// evtransfer, evconfirm, evexec and evfailed
+export type TReportEvent = {
+  report_id: number | string;
+  from_blockchain: string;
+  transfer_id: number | string;
+};
+
+export type TIbcEvent =
+  | { name: `evtransfer`; data: { transfer: TTransfersRow } }
+  | { name: `evconfirm` | `evexec` | `evfailed`; data: { event: TReportEvent } };
+
+// action trace as emitted by history solutions / state history consumers
+export type TActionTraceRecord = {
+  receipt: {
+    global_sequence: number | string;
+  };
+  act: {
+    account: string;
+    name: string;
+    data: any;
+  };
+};
+
+export interface TraceSource {
+  // returns the traces that became available since the last call
+  read(): Promise<TActionTraceRecord[]>;
+  // where the next read continues, saved across restarts
+  position: number;
+}
+
+// resume point of an EventLog
+export type TEventCheckpoint = { position: number; sequence: number };
+
+const openFile = promisify(fs.open);
+const fstat = promisify(fs.fstat);
+const readFile = promisify(fs.read);
+const closeFile = promisify(fs.close);
+
+// newline-delimited JSON action traces, appended to by an external process
+export class FileTraceSource implements TraceSource {
+  path: string;
+  // byte offset after the last complete line that was read
+  position = 0;
+
+  constructor(path: string) {
+    this.path = path;
+  }
+
+  async read() {
+    let fd: number;
+    try {
+      fd = await openFile(this.path, `r`);
+    } catch (error) {
+      if (error.code === `ENOENT`) return [];
+      throw error;
+    }
+
+    try {
+      const { size } = await fstat(fd);
+      // file got truncated / rotated, start over
+      if (size < this.position) this.position = 0;
+      if (size === this.position) return [];
+
+      const buffer = Buffer.alloc(size - this.position);
+      const { bytesRead } = await readFile(
+        fd,
+        buffer,
+        0,
+        buffer.length,
+        this.position
+      );
+
+      // a line that is still being written is read again once it is complete
+      const end = buffer.lastIndexOf(0x0a, bytesRead - 1);
+      if (end === -1) return [];
+
+      const traces: TActionTraceRecord[] = [];
+      buffer
+        .toString(`utf8`, 0, end)
+        .split(`\n`)
+        .forEach((line) => {
+          if (line.trim().length === 0) return;
+          try {
+            traces.push(JSON.parse(line));
+          } catch (error) {
+            logger.warn(
+              `Skipping corrupt trace in ${this.path}: ${error.message}`
+            );
+          }
+        });
+      this.position += end + 1;
+      return traces;
+    } finally {
+      await closeFile(fd);
+    }
+  }
+}
+
+// in-process stand-in for the history stream
+export class MemoryTraceSource implements TraceSource {
+  position = 0;
+  private pending: TActionTraceRecord[] = [];
+
+  push(...traces: TActionTraceRecord[]) {
+    this.pending.push(...traces);
+  }
+
+  async read() {
+    const traces = this.pending;
+    this.pending = [];
+    this.position += traces.length;
+    return traces;
+  }
+}
+
+const EVENT_NAMES = [`evtransfer`, `evconfirm`, `evexec`, `evfailed`];
+
+// hands out every event of the contract exactly once, in chain order
+export class EventLog {
+  contract: string;
+  source: TraceSource;
+  // global_sequence is strictly increasing on a chain
+  lastSequence = -1;
+
+  constructor(contract: string, source: TraceSource) {
+    this.contract = contract;
+    this.source = source;
+  }
+
+  async poll(): Promise<TIbcEvent[]> {
+    const traces = await this.source.read();
+    const events: TIbcEvent[] = [];
+
+    traces
+      .filter(
+        (t) =>
+          t.act.account === this.contract &&
+          EVENT_NAMES.indexOf(t.act.name) !== -1
+      )
+      .map((t) => ({
+        sequence: Number.parseInt(`${t.receipt.global_sequence}`, 10),
+        trace: t,
+      }))
+      .sort((a, b) => a.sequence - b.sequence)
+      .forEach(({ sequence, trace }) => {
+        if (sequence <= this.lastSequence) return;
+        this.lastSequence = sequence;
+        events.push({ name: trace.act.name, data: trace.act.data } as TIbcEvent);
+      });
+
+    return events;
+  }
+
+  checkpoint(): TEventCheckpoint {
+    return { position: this.source.position, sequence: this.lastSequence };
+  }
+
+  restore(checkpoint: TEventCheckpoint) {
+    this.source.position = checkpoint.position;
+    this.lastSequence = checkpoint.sequence;
+  }
+}
+
+// reads <NETWORK>_TRACE_FILE, returns undefined if the reporter should poll
+export const getEventLog = (network: NetworkName, contract: string) => {
+  const path =
+    process.env[`${unmapNetworkName(network).toUpperCase()}_TRACE_FILE`];
+  if (!path) return undefined;
+
+  return new EventLog(contract, new FileTraceSource(path));
+};
@@ -1,11 +1,13 @@
 import { Action } from "eosjs/dist/eosjs-serialize";
 import { NetworkName } from "../types";
 import { getApi } from "./api";
-import { getContractsForNetwork, getRpc } from "./networks";
+import { getContractsForNetwork, getNetwork, getRpc } from "./networks";
+import { TSerializedAction } from "./templates";
 import { logger } from "../logger";
 import { TTransactionResult } from "./types";
 import { getEnvConfig } from "../dotenv";
 import { unmapNetworkName, sleep } from "../utils";
+import { PUSH_TIMEOUT_MS } from "./pool";
 
 // https://github.com/EOSIO/eosjs-api/blob/master/docs/api.md#eos.getTableRows
 type GetTableRowsOptions = {
@@ -123,16 +125,94 @@ export const fetchHeadBlockNumbers = (network: NetworkName) => async () => {
   };
 };
 
+// the last irreversible block cannot be forked out and stays a valid TAPOS
+// reference for hours, re-fetching it once a minute is plenty
+const TAPOS_TTL_MS = 60 * 1e3;
+// if background refreshes keep failing, an older reference is not served;
+// ref_block_num wraps after 2^16 blocks and the chain would reject it
+const TAPOS_MAX_AGE_MS = 10 * 60 * 1e3;
+const EXPIRE_SECONDS = 60 * 5;
+// TAPOS lookup and signing get as long as the push itself, the push has to
+// time out first so that a contract check failure is not hidden behind a
+// plain timeout
+const SEND_TIMEOUT_MS = 2 * PUSH_TIMEOUT_MS;
+
+type TTapos = {
+  refBlockNum: number;
+  refBlockPrefix: number;
+  headTimeMs: number;
+  fetchedAt: number;
+};
+
+const fetchTapos = async (network: NetworkName): Promise<TTapos> => {
+  const rpc = getRpc(network);
+  const info = await rpc.get_info();
+  const block = await rpc.get_block(info.last_irreversible_block_num);
+  return {
+    refBlockNum: block.block_num & 0xffff,
+    refBlockPrefix: block.ref_block_prefix,
+    headTimeMs: Date.parse(`${info.head_block_time}Z`),
+    fetchedAt: Date.now(),
+  };
+};
+
+export const getTapos: (
+  network: NetworkName
+) => Promise<TTapos> = (() => {
+  const cache: { [network: string]: Promise<TTapos> } = {};
+  const refreshing: { [network: string]: boolean } = {};
+
+  return (network: NetworkName) => {
+    const cached = cache[network];
+    if (!cached) {
+      cache[network] = fetchTapos(network);
+      cache[network].catch(() => delete cache[network]);
+      return cache[network];
+    }
+
+    return cached.then((tapos) => {
+      const age = Date.now() - tapos.fetchedAt;
+      if (age > TAPOS_MAX_AGE_MS) {
+        // another caller already started the fetch
+        if (cache[network] !== cached) return getTapos(network);
+        // callers wait for the fetch, a failure is a retryable error
+        const fetched = fetchTapos(network);
+        cache[network] = fetched;
+        fetched.catch(() => {
+          if (cache[network] === fetched) delete cache[network];
+        });
+        return fetched;
+      }
+      if (age > TAPOS_TTL_MS && !refreshing[network]) {
+        // refresh in the background, the cached reference is still valid
+        refreshing[network] = true;
+        const refreshed = fetchTapos(network);
+        refreshed
+          .then(
+            () => (cache[network] = refreshed),
+            (error) =>
+              logger.warn(
+                `Could not refresh TAPOS on ${network}: ${error.message}`
+              )
+          )
+          .then(() => (refreshing[network] = false));
+      }
+      return tapos;
+    });
+  };
+})();
+
+const isSerialized = (action: Action | TSerializedAction) =>
+  typeof action.data === `string`;
+
+// Builds, signs and pushes the transaction with a single RPC call: TAPOS
+// comes from the cache, the chain id is known, signing is local and actions
+// pre-serialized from a template are used as they are.
 export const sendTransaction = (network: NetworkName) => async (
-  actions: Action | Action[]
+  actions: Action | TSerializedAction | (Action | TSerializedAction)[]
 ): Promise<TTransactionResult> => {
-  let _actions = Array.isArray(actions) ? actions : [actions];
-  const txOptions = {
-    broadcast: true,
-    sign: true,
-    blocksBehind: 3,
-    expireSeconds: 60 * 5,
-  };
+  // copy, the payforcpu action must not leak into the caller's array
+  let _actions = Array.isArray(actions) ? actions.slice() : [actions];
   const eosApi = getApi(network);
 
   const config = getEnvConfig()[unmapNetworkName(network)];
@@ -146,17 +226,49 @@ export const sendTransaction = (network: NetworkName) => async (
           permission: `payforcpu`,
         },
       ],
-      data: {},
+      // no arguments
+      data: ``,
     });
   }
 
+  const push = async () => {
+    // ABIs are cached by the Api after the first lookup
+    const [tapos, serializedActions] = await Promise.all([
+      getTapos(network),
+      Promise.all(
+        _actions.map(async (action) =>
+          isSerialized(action)
+            ? action
+            : (await eosApi.serializeActions([action as Action]))[0]
+        )
+      ),
+    ]);
+    const expirationMs =
+      tapos.headTimeMs + (Date.now() - tapos.fetchedAt) + EXPIRE_SECONDS * 1e3;
+    const serializedTransaction = eosApi.serializeTransaction({
+      expiration: new Date(expirationMs).toISOString().split(`.`)[0],
+      ref_block_num: tapos.refBlockNum,
+      ref_block_prefix: tapos.refBlockPrefix,
+      max_net_usage_words: 0,
+      max_cpu_usage_ms: 0,
+      delay_sec: 0,
+      context_free_actions: [],
+      actions: serializedActions,
+      transaction_extensions: [],
+    });
+    // only the reporter key and, with a cpu payer, its key are loaded
+    const requiredKeys = await eosApi.signatureProvider.getAvailableKeys();
+    const signatures = await eosApi.signatureProvider.sign({
+      chainId: getNetwork(unmapNetworkName(network)).chainId,
+      requiredKeys,
+      serializedTransaction,
+      abis: [],
+    });
+    return eosApi.rpc.push_transaction({ signatures, serializedTransaction });
+  };
+
   return Promise.race([
-    eosApi.transact(
-      {
-        actions: _actions,
-      },
-      txOptions
-    ),
-    sleep(10000, `sendTransaction timed out`) as any
+    push(),
+    sleep(SEND_TIMEOUT_MS, `sendTransaction timed out`) as any,
   ]);
 };
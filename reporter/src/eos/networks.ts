@@ -1,18 +1,38 @@
 import { JsonRpc } from "eosjs";
-import fetch from "node-fetch";
 import { NetworkName } from "../types";
 import { getEnvConfig } from "../dotenv";
 import { isProduction, unmapNetworkName } from "../utils";
+import EndpointPool, { PooledJsonRpc } from "./pool";
 
-export const getContractsForNetwork = (
-  network: NetworkName
-): {
+// nodes every transaction is pushed to, if that many endpoints are configured
+const BROADCAST_NODES = Number.parseInt(process.env.BROADCAST_NODES || `2`, 10);
+
+type TNetworkContracts = {
   token: string;
   ibc: string;
   cpuPayer: string;
   reporterAccount: string;
   reporterPermission: string;
-} => {
+};
+
+// env config does not change at runtime, resolve it once per network
+export const getContractsForNetwork: (
+  network: NetworkName
+) => TNetworkContracts = (() => {
+  const contracts = {};
+
+  return (network: NetworkName) => {
+    if (!contracts[network]) {
+      contracts[network] = resolveContractsForNetwork(network);
+    }
+
+    return contracts[network];
+  };
+})();
+
+const resolveContractsForNetwork = (
+  network: NetworkName
+): TNetworkContracts => {
   network = unmapNetworkName(network);
   const envConfig = getEnvConfig();
   switch (network) {
@@ -51,7 +71,7 @@ export const getContractsForNetwork = (
   }
 };
 
-const createNetwork = (nodeEndpoint, chainId) => {
+const parseEndpoint = (nodeEndpoint, chainId) => {
   const matches = /^(https?):\/\/(.+?)(:\d+){0,1}$/.exec(nodeEndpoint);
   if (!matches) {
     throw new Error(
@@ -76,6 +96,15 @@ const createNetwork = (nodeEndpoint, chainId) => {
   };
 };
 
+// the endpoint variables take a comma-separated list of nodes
+const createNetwork = (nodeEndpoints, chainId) => ({
+  chainId,
+  nodeEndpoints: `${nodeEndpoints}`
+    .split(`,`)
+    .map((nodeEndpoint) => parseEndpoint(nodeEndpoint.trim(), chainId))
+    .map((network) => network.nodeEndpoint),
+});
+
 const KylinNetwork = createNetwork(
   process.env.KYLIN_ENDPOINT || `https://kylin.eosn.io`,
   `5fff1dae8dc8e2fc4d5b23b2c7665c97f9e9d8edf2b6485a86ba311c25639191`
@@ -93,7 +122,7 @@ const WaxNetwork = createNetwork(
   `1064487b3cd1a897ce03ae5b6a865651747e2e152090f99c1d19d44e01aea5a4`
 );
 
-function getNetwork(networkName: string) {
+export function getNetwork(networkName: string) {
   switch (networkName) {
     case `eos`:
       return MainNetwork;
@@ -108,15 +137,28 @@ function getNetwork(networkName: string) {
   }
 }
 
+export const getPool: (networkName: string) => EndpointPool = (() => {
+  const pools = {};
+
+  return (networkName: string) => {
+    let _networkName = unmapNetworkName(networkName as NetworkName);
+    if (!pools[_networkName]) {
+      pools[_networkName] = new EndpointPool(
+        getNetwork(_networkName).nodeEndpoints,
+        { broadcastCount: BROADCAST_NODES }
+      );
+    }
+
+    return pools[_networkName];
+  };
+})();
+
 export const getRpc: (networkName: string) => JsonRpc = (() => {
   const rpcs = {};
 
   return (networkName: string) => {
-    let _networkName = unmapNetworkName(networkName as NetworkName);
     if (!rpcs[networkName]) {
-      rpcs[networkName] = new JsonRpc(getNetwork(_networkName).nodeEndpoint, {
-        fetch: fetch,
-      });
+      rpcs[networkName] = new PooledJsonRpc(getPool(networkName));
     }
 
     return rpcs[networkName];
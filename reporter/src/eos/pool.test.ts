@@ -0,0 +1,198 @@
+import * as http from "http";
+import { JsonRpc } from "eosjs";
+import EndpointPool from "./pool";
+import { isActionFailure } from "../utils/pipeline";
+
+// a local node answering every path after `latencyMs` with `status` / `body`
+type TStub = {
+  url: string;
+  latencyMs: number;
+  status: number;
+  body: any;
+  requests: string[];
+  close: () => Promise<void>;
+};
+
+const startStub = (latencyMs: number): Promise<TStub> =>
+  new Promise((resolve) => {
+    const sockets: any[] = [];
+    const server = http.createServer((req, res) => {
+      stub.requests.push(req.url);
+      // drain the request body before answering
+      req.on(`data`, () => undefined);
+      req.on(`end`, () =>
+        setTimeout(() => {
+          res.writeHead(stub.status, { "Content-Type": `application/json` });
+          res.end(JSON.stringify({ url: stub.url, ...stub.body }));
+        }, stub.latencyMs)
+      );
+    });
+    server.on(`connection`, (socket) => sockets.push(socket));
+    const stub: TStub = {
+      url: ``,
+      latencyMs,
+      status: 200,
+      body: {},
+      requests: [],
+      // hanging requests are cut off
+      close: () =>
+        new Promise((done) => {
+          sockets.forEach((socket) => socket.destroy());
+          server.close(() => done());
+        }),
+    };
+    server.listen(0, `127.0.0.1`, () => {
+      const { port } = server.address() as { port: number };
+      stub.url = `http://127.0.0.1:${port}`;
+      resolve(stub);
+    });
+  });
+
+const assertFailure = {
+  code: 500,
+  message: `Internal Service Error`,
+  error: {
+    code: 3050003,
+    name: `eosio_assert_message_exception`,
+    what: `eosio_assert_message assertion failure`,
+    details: [{ message: `assertion failure with message: already executed` }],
+  },
+};
+const nodeFailure = {
+  code: 500,
+  message: `Internal Service Error`,
+  error: {
+    code: 3010000,
+    name: `http_error`,
+    what: `node failure`,
+    details: [],
+  },
+};
+
+const getInfo = (rpc: JsonRpc) => rpc.fetch(`/v1/chain/get_info`, {});
+const push = (rpc: JsonRpc) =>
+  rpc.fetch(`/v1/chain/push_transaction`, { signatures: [] });
+const countOf = (stub: TStub, path: string) =>
+  stub.requests.filter((url) => url === path).length;
+
+describe("EndpointPool", () => {
+  let stubs: TStub[] = [];
+  const start = async (...latencies: number[]) => {
+    stubs = await Promise.all(latencies.map(startStub));
+    return stubs;
+  };
+
+  afterEach(async () => {
+    jest.restoreAllMocks();
+    await Promise.all(stubs.map((stub) => stub.close()));
+    stubs = [];
+  });
+
+  it("routes reads to the node with the lowest moving average latency", async () => {
+    const [slow, fast] = await start(100, 5);
+    const pool = new EndpointPool([slow.url, fast.url]);
+
+    // untried nodes are ranked first, afterwards only the fast one is used
+    for (let i = 0; i < 10; i += 1) {
+      await pool.read(getInfo);
+    }
+
+    expect(pool.ranked()[0].url).toEqual(fast.url);
+    expect(slow.requests.length).toEqual(1);
+    expect(fast.requests.length).toEqual(9);
+  });
+
+  it("hedges a read to the second best node after the recent p95", async () => {
+    const [first, second] = await start(5, 5);
+    const pool = new EndpointPool([first.url, second.url]);
+
+    // the hedge delay is derived from 32 samples
+    for (let i = 0; i < 32; i += 1) {
+      await pool.read(getInfo);
+    }
+    expect(pool.hedgeDelayMs).toBeLessThan(1000);
+
+    const [primary, secondary] = pool
+      .ranked()
+      .map((endpoint) => stubs.find((stub) => stub.url === endpoint.url));
+    primary.latencyMs = 2000;
+    const secondaryReads = secondary.requests.length;
+
+    const startedAt = Date.now();
+    const result = await pool.read(getInfo);
+
+    expect(result.url).toEqual(secondary.url);
+    expect(secondary.requests.length).toEqual(secondaryReads + 1);
+    expect(Date.now() - startedAt).toBeLessThan(1000);
+  });
+
+  it("penalizes a failing node until the penalty decays", async () => {
+    const [flaky, steady] = await start(10, 300);
+    const pool = new EndpointPool([flaky.url, steady.url]);
+
+    await pool.read(getInfo);
+    await pool.read(getInfo);
+    expect(pool.ranked()[0].url).toEqual(flaky.url);
+
+    // fails fast, the read is hedged to the other node right away
+    flaky.status = 500;
+    flaky.body = nodeFailure;
+    const result = await pool.read(getInfo);
+    expect(result.url).toEqual(steady.url);
+    expect(pool.ranked()[0].url).toEqual(steady.url);
+
+    // ten half-lives later the node is tried again
+    flaky.status = 200;
+    flaky.body = {};
+    const now = Date.now();
+    jest.spyOn(Date, `now`).mockReturnValue(now + 10 * 60 * 1e3);
+    expect(pool.ranked()[0].url).toEqual(flaky.url);
+    expect((await pool.read(getInfo)).url).toEqual(flaky.url);
+  });
+
+  it("pushes transactions to the best broadcastCount nodes", async () => {
+    const nodes = await start(5, 5, 5);
+    const pool = new EndpointPool(
+      nodes.map((stub) => stub.url),
+      { broadcastCount: 2 }
+    );
+
+    await pool.broadcast(push);
+
+    expect(
+      nodes.map((stub) => countOf(stub, `/v1/chain/push_transaction`))
+    ).toEqual([1, 1, 0]);
+  });
+
+  it("returns a failed contract check without waiting for a hanging node", async () => {
+    const [asserting, hanging] = await start(5, 4000);
+    asserting.status = 500;
+    asserting.body = assertFailure;
+    const pool = new EndpointPool([asserting.url, hanging.url], {
+      broadcastCount: 2,
+    });
+
+    const startedAt = Date.now();
+    const error = await pool.broadcast(push).catch((e) => e);
+
+    expect(isActionFailure(error)).toBe(true);
+    expect(Date.now() - startedAt).toBeLessThan(1000);
+  });
+
+  it("rejects a push once all nodes failed", async () => {
+    const [first, second] = await start(5, 20);
+    [first, second].forEach((stub) => {
+      stub.status = 500;
+      stub.body = nodeFailure;
+    });
+    const pool = new EndpointPool([first.url, second.url], {
+      broadcastCount: 2,
+    });
+
+    const error = await pool.broadcast(push).catch((e) => e);
+
+    expect(error.json.error.name).toEqual(`http_error`);
+    expect(isActionFailure(error)).toBe(false);
+    expect(countOf(second, `/v1/chain/push_transaction`)).toEqual(1);
+  });
+});
@@ -0,0 +1,253 @@
+import { JsonRpc, RpcError } from "eosjs";
+import fetch from "node-fetch";
+import { rpcDuration } from "../utils/metrics";
+import { isActionFailure } from "../utils/pipeline";
+
+// weight of the latest sample in the moving averages
+const EWMA_ALPHA = 0.2;
+// an endpoint's error penalty halves every minute so it gets retried
+const ERROR_HALF_LIFE_MS = 60 * 1e3;
+const ERROR_PENALTY = 10;
+// recent read latencies of the pool the hedge delay is derived from
+const LATENCY_SAMPLES = 128;
+const MIN_LATENCY_SAMPLES = 20;
+const HEDGE_PERCENTILE = 0.95;
+const MIN_HEDGE_DELAY_MS = 50;
+const DEFAULT_HEDGE_DELAY_MS = 1000;
+const REQUEST_TIMEOUT_MS = 10 * 1e3;
+// a hanging node must not hold back the other broadcast targets' answers
+// beyond sendTransaction's own deadline
+export const PUSH_TIMEOUT_MS = 5 * 1e3;
+
+const PUSH_PATHS = [`/v1/chain/push_transaction`, `/v1/chain/send_transaction`];
+
+type TEndpoint = {
+  url: string;
+  rpc: JsonRpc;
+  // 0 until the first response, untried endpoints are ranked first
+  latencyMs: number;
+  errorRate: number;
+  lastErrorAt: number;
+};
+
+type TPoolOptions = {
+  // stub servers / custom fetch implementations can be injected here
+  createRpc?: (url: string) => JsonRpc;
+  // number of endpoints a transaction is pushed to
+  broadcastCount?: number;
+};
+
+// Routes reads to the fastest healthy endpoint of a network, ranked by EWMA
+// latency and error rate. A read that takes longer than the pool's recent
+// p95 latency is hedged to the second best endpoint, the first response wins.
+export default class EndpointPool {
+  endpoints: TEndpoint[];
+  broadcastCount: number;
+  private samples = new Float64Array(LATENCY_SAMPLES);
+  private sampleCount = 0;
+  private hedgeDelay = DEFAULT_HEDGE_DELAY_MS;
+
+  constructor(urls: string[], options: TPoolOptions = {}) {
+    if (urls.length === 0) throw new Error(`EndpointPool: no endpoints`);
+
+    const createRpc =
+      options.createRpc || ((url: string) => new JsonRpc(url, { fetch }));
+    this.endpoints = urls.map((url) => ({
+      url,
+      rpc: createRpc(url),
+      latencyMs: 0,
+      errorRate: 0,
+      lastErrorAt: 0,
+    }));
+    this.broadcastCount = options.broadcastCount || 1;
+  }
+
+  get urls() {
+    return this.endpoints.map((e) => e.url);
+  }
+
+  get hedgeDelayMs() {
+    return this.hedgeDelay;
+  }
+
+  // best endpoint first
+  ranked(): TEndpoint[] {
+    const now = Date.now();
+    const score = (e: TEndpoint) =>
+      e.latencyMs *
+      (1 +
+        ERROR_PENALTY *
+          e.errorRate *
+          Math.pow(0.5, (now - e.lastErrorAt) / ERROR_HALF_LIFE_MS));
+    return this.endpoints.slice().sort((a, b) => score(a) - score(b));
+  }
+
+  read<T>(request: (rpc: JsonRpc) => Promise<T>): Promise<T> {
+    const [primary, secondary] = this.ranked();
+    if (!secondary) return this.call(primary, request, true);
+
+    return new Promise<T>((resolve, reject) => {
+      let pending = 0;
+      let hedged = false;
+      let settled = false;
+      let timer: ReturnType<typeof setTimeout> = null;
+
+      const attempt = (endpoint: TEndpoint) => {
+        pending += 1;
+        this.call(endpoint, request, true).then(
+          (result) => {
+            if (settled) return;
+            settled = true;
+            clearTimeout(timer);
+            resolve(result);
+          },
+          (error) => {
+            pending -= 1;
+            if (settled) return;
+            // primary failed fast, no need to wait for the hedge delay
+            if (!hedged) return hedge();
+            if (pending === 0) {
+              settled = true;
+              reject(error);
+            }
+          }
+        );
+      };
+      const hedge = () => {
+        if (hedged || settled) return;
+        hedged = true;
+        clearTimeout(timer);
+        attempt(secondary);
+      };
+
+      timer = setTimeout(hedge, this.hedgeDelay);
+      attempt(primary);
+    });
+  }
+
+  // pushes to the best `broadcastCount` endpoints, resolves with the first
+  // accepted response. A failed contract check is deterministic and rejects
+  // right away, otherwise it rejects with the best endpoint's error once all
+  // targets answered
+  broadcast<T>(request: (rpc: JsonRpc) => Promise<T>): Promise<T> {
+    const targets = this.ranked().slice(0, this.broadcastCount);
+
+    return new Promise<T>((resolve, reject) => {
+      const errors: any[] = [];
+      let pending = targets.length;
+      let settled = false;
+
+      targets.forEach((endpoint, index) =>
+        this.call(endpoint, request, false).then(
+          (result) => {
+            if (settled) return;
+            settled = true;
+            resolve(result);
+          },
+          (error) => {
+            errors[index] = error;
+            pending -= 1;
+            if (settled || (pending > 0 && !isActionFailure(error))) return;
+            settled = true;
+            reject(isActionFailure(error) ? error : errors.filter(Boolean)[0]);
+          }
+        )
+      );
+    });
+  }
+
+  // rejected transactions are not the endpoint's fault, only count
+  // RpcErrors against it for reads
+  private async call<T>(
+    endpoint: TEndpoint,
+    request: (rpc: JsonRpc) => Promise<T>,
+    isRead: boolean
+  ): Promise<T> {
+    const start = Date.now();
+    let timer: ReturnType<typeof setTimeout> = null;
+    const timeout = new Promise<T>((_, reject) => {
+      timer = setTimeout(
+        () => reject(new Error(`${endpoint.url} timed out`)),
+        isRead ? REQUEST_TIMEOUT_MS : PUSH_TIMEOUT_MS
+      );
+    });
+    try {
+      const result = await Promise.race([request(endpoint.rpc), timeout]);
+      this.record(endpoint, Date.now() - start, false, isRead);
+      return result;
+    } catch (error) {
+      const isEndpointError = isRead || !(error instanceof RpcError);
+      this.record(endpoint, Date.now() - start, isEndpointError, isRead);
+      throw error;
+    } finally {
+      clearTimeout(timer);
+    }
+  }
+
+  private record(
+    endpoint: TEndpoint,
+    latencyMs: number,
+    isError: boolean,
+    isRead: boolean
+  ) {
+    endpoint.errorRate =
+      EWMA_ALPHA * (isError ? 1 : 0) + (1 - EWMA_ALPHA) * endpoint.errorRate;
+    if (isError) {
+      endpoint.lastErrorAt = Date.now();
+      // refused connections fail fast but must not look fast
+      latencyMs = Math.max(latencyMs, endpoint.latencyMs, this.hedgeDelay);
+    }
+    endpoint.latencyMs =
+      endpoint.latencyMs === 0
+        ? latencyMs
+        : EWMA_ALPHA * latencyMs + (1 - EWMA_ALPHA) * endpoint.latencyMs;
+
+    if (!isRead || isError) return;
+    this.samples[this.sampleCount % LATENCY_SAMPLES] = latencyMs;
+    this.sampleCount += 1;
+    // re-derive the hedge delay every few samples, sorting is cheap at 128
+    if (
+      this.sampleCount >= MIN_LATENCY_SAMPLES &&
+      this.sampleCount % 16 === 0
+    ) {
+      const count = Math.min(this.sampleCount, LATENCY_SAMPLES);
+      const sorted = Array.prototype.slice
+        .call(this.samples, 0, count)
+        .sort((a: number, b: number) => a - b);
+      this.hedgeDelay = Math.max(
+        MIN_HEDGE_DELAY_MS,
+        sorted[Math.min(count - 1, Math.floor(count * HEDGE_PERCENTILE))]
+      );
+    }
+  }
+}
+
+// JsonRpc whose requests go through an EndpointPool, reads are routed and
+// hedged, transactions are broadcast. Drop-in for eosjs' Api and fetch.ts.
+export class PooledJsonRpc extends JsonRpc {
+  pool: EndpointPool;
+
+  constructor(pool: EndpointPool) {
+    super(pool.urls[0], { fetch });
+    this.pool = pool;
+  }
+
+  async fetch(path: string, body: any): Promise<any> {
+    const request = (rpc: JsonRpc) => {
+      const observe = rpcDuration.labels(rpc.endpoint, path).startTimer();
+      return rpc.fetch(path, body).then(
+        (result) => {
+          observe();
+          return result;
+        },
+        (error) => {
+          observe();
+          throw error;
+        }
+      );
+    };
+
+    if (PUSH_PATHS.indexOf(path) !== -1) return this.pool.broadcast(request);
+    return this.pool.read(request);
+  }
+}
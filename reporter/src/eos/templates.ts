@@ -0,0 +1,144 @@
+import { Serialize } from "eosjs";
+import { TextDecoder, TextEncoder } from "util";
+import { NetworkName } from "../types";
+import { logger } from "../logger";
+import { getApi } from "./api";
+import { getContractsForNetwork } from "./networks";
+
+// ABIs are re-fetched in the background after this, in case of an upgrade
+const ABI_TTL_MS = 10 * 60 * 1e3;
+
+export type TSerializedAction = {
+  account: string;
+  name: string;
+  authorization: { actor: string; permission: string }[];
+  // hex encoded action data
+  data: string;
+};
+
+// An action of the ibc contract whose leading fixed fields (the reporter)
+// are serialized once, only the remaining fields are serialized per call.
+export class ActionTemplate {
+  account: string;
+  name: string;
+  authorization: { actor: string; permission: string }[];
+  private prefix: Uint8Array;
+  private fields: Serialize.Field[];
+
+  constructor(
+    account: string,
+    name: string,
+    authorization: { actor: string; permission: string }[],
+    type: Serialize.Type,
+    fixedData: { [field: string]: any }
+  ) {
+    this.account = account;
+    this.name = name;
+    this.authorization = authorization;
+
+    const buffer = createBuffer();
+    let fixedCount = 0;
+    while (
+      fixedCount < type.fields.length &&
+      type.fields[fixedCount].name in fixedData
+    ) {
+      const field = type.fields[fixedCount];
+      field.type.serialize(buffer, fixedData[field.name]);
+      fixedCount += 1;
+    }
+    this.prefix = buffer.asUint8Array();
+    this.fields = type.fields.slice(fixedCount);
+  }
+
+  serialize(data: { [field: string]: any }): TSerializedAction {
+    const buffer = createBuffer();
+    buffer.pushArray(this.prefix);
+    this.fields.forEach((field) =>
+      field.type.serialize(buffer, data[field.name])
+    );
+
+    return {
+      account: this.account,
+      name: this.name,
+      authorization: this.authorization,
+      data: Serialize.arrayToHex(buffer.asUint8Array()),
+    };
+  }
+}
+
+const textEncoder = new TextEncoder() as any;
+const textDecoder = new TextDecoder() as any;
+const createBuffer = () =>
+  new Serialize.SerialBuffer({ textEncoder, textDecoder });
+
+type TActionTemplates = {
+  report: ActionTemplate;
+  exec: ActionTemplate;
+  execfailed: ActionTemplate;
+};
+
+const loadActionTemplates = async (
+  network: NetworkName,
+  reload: boolean
+): Promise<TActionTemplates> => {
+  const contracts = getContractsForNetwork(network);
+  const contract = await getApi(network).getContract(contracts.ibc, reload);
+  const authorization = [
+    {
+      actor: contracts.reporterAccount,
+      permission: contracts.reporterPermission,
+    },
+  ];
+  const create = (name: string) => {
+    const type = contract.actions.get(name);
+    if (!type)
+      throw new Error(`ABI of ${contracts.ibc} has no action "${name}"`);
+    return new ActionTemplate(contracts.ibc, name, authorization, type, {
+      reporter: contracts.reporterAccount,
+    });
+  };
+
+  return {
+    report: create(`report`),
+    exec: create(`exec`),
+    execfailed: create(`execfailed`),
+  };
+};
+
+// the reporter's actions on the ibc contract of a network
+export const getActionTemplates: (
+  network: NetworkName
+) => Promise<TActionTemplates> = (() => {
+  const cache: {
+    [network: string]: {
+      loadedAt: number;
+      templates: Promise<TActionTemplates>;
+    };
+  } = {};
+
+  return (network: NetworkName) => {
+    const now = Date.now();
+    const entry = cache[network];
+
+    if (!entry) {
+      const templates = loadActionTemplates(network, false);
+      cache[network] = { loadedAt: now, templates };
+      // retry on the next call
+      templates.catch(() => delete cache[network]);
+      return templates;
+    }
+
+    // keep serving the current templates while the ABI is refreshed
+    if (now - entry.loadedAt > ABI_TTL_MS) {
+      entry.loadedAt = now;
+      const reloaded = loadActionTemplates(network, true);
+      reloaded.then(
+        () => (entry.templates = reloaded),
+        (error) =>
+          logger.warn(`Could not refresh ABI on ${network}: ${error.message}`)
+      );
+    }
+
+    return entry.templates;
+  };
+})();
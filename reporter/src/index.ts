@@ -6,7 +6,7 @@ import { Routes } from "./routes";
 import { logger } from "./logger";
 import { NETWORKS_TO_WATCH } from "./utils";
 import Reporter from "./reporter";
-import { getRpc } from "./eos/networks";
+import { getPool } from "./eos/networks";
 
 async function start() {
   const app = express();
@@ -49,7 +49,7 @@ async function start() {
     `Reporter v${VERSION}: Express server has started on port ${PORT}. Open http://localhost:${PORT}/logs`
   );
   logger.info(
-    `Using endpoints ${NETWORKS_TO_WATCH.map(network => getRpc(network).endpoint).join(`, `)}`
+    `Using endpoints ${NETWORKS_TO_WATCH.map(network => `${network}: ${getPool(network).urls.join(`, `)}`).join(`; `)}`
   );
 
   const reporters = NETWORKS_TO_WATCH.map(
@@ -1,9 +1,13 @@
 import {
   fetchAllRows,
   fetchHeadBlockNumbers,
+  getTapos,
   sendTransaction,
 } from "./eos/fetch";
+import { EventLog, getEventLog } from "./eos/events";
 import { getContractsForNetwork } from "./eos/networks";
+import { getActionTemplates } from "./eos/templates";
+import { TTransactionResult } from "./eos/types";
 import { logger } from "./logger";
 import {
   isNetworkName,
@@ -16,22 +20,151 @@ import {
 import {
   extractRpcError,
   formatBloksTransaction,
-  pickRandom,
+  shuffle,
   sleep,
 } from "./utils";
 import { pulse, pulseError } from "./utils/health";
+import * as metrics from "./utils/metrics";
+import SubmissionPipeline, { isActionFailure } from "./utils/pipeline";
+import ReporterState from "./utils/state";
+
+// every n-th poll re-fetches all rows instead of only new ones
+const FULL_SYNC_INTERVAL = 60;
+// pending reports are refreshed in id ranges of at most this span
+const PENDING_RANGE_SPAN = 100;
+// concurrent report / exec transactions per reporter
+const MAX_IN_FLIGHT = Number.parseInt(process.env.MAX_IN_FLIGHT || `8`, 10);
+// submitted rows are skipped until the polled tables reflect them
+const SETTLE_MS = 60 * 1e3;
+// a pending report is re-fetched well before a row submitted with its state
+// leaves the settle window
+const PENDING_MAX_AGE_MS = SETTLE_MS / 2;
+// actions packed into one transaction, bounded by their estimated CPU cost
+const MAX_ACTIONS_PER_TX = Number.parseInt(
+  process.env.MAX_ACTIONS_PER_TX || `10`,
+  10
+);
+const TX_CPU_BUDGET_US = Number.parseInt(
+  process.env.TX_CPU_BUDGET_US || `10000`,
+  10
+);
+const ACTION_CPU_ESTIMATE_US = {
+  report: 500,
+  exec: 1000,
+};
+// the action was already applied by another reporter or transaction
+const isDuplicateError = (error: any) =>
+  /already reported|already executed|already failed|duplicate transaction/i.test(
+    extractRpcError(error) || ``
+  );
 
 export default class Reporter {
   network: NetworkName;
-  transfers: TTransfersRowTransformed[] = [];
-  transferIrreversibilityMap: { [key: string]: number } = {};
-  reports: TReportsRowTransformed[] = [];
+  // keyed by getInternalUniqueTransferId
+  transfers = new Map<string, TTransfersRowTransformed>();
+  // first-seen blocks and submitted transactions, survives restarts
+  state: ReporterState;
+  // x-chain reports keyed by report id
+  reports = new Map<number, TReportsRowTransformed>();
+  // unique transfer ids of reports that this reporter confirmed
+  reportedTransferIds = new Set<string>();
+  // when each report was last fetched, keyed by report id
+  reportsFetchedAt = new Map<number, number>();
   currentHeadBlock = Infinity;
   currentHeadTime = new Date().toISOString();
   currentIrreversibleHeadBlock = Infinity;
+  // set if transfers are ingested from the contract's event log
+  eventLog?: EventLog;
+  // the event log resumes at its saved checkpoint, transfers logged before
+  // it are loaded from the table once
+  transfersTableLoaded = false;
+  // highest primary keys seen, polls only fetch rows above them
+  transfersWatermark = -1;
+  reportsWatermark = -1;
+  // set when the report at the watermark disappeared, ids may be reused
+  reportsResync = false;
+  pollCount = 0;
+  reportPipeline: SubmissionPipeline<TTransfersRowTransformed>;
+  execPipeline: SubmissionPipeline<TReportsRowTransformed>;
+  startedAt = Date.now();
+  // unique transfer ids whose irreversibility delay was observed
+  irreversibleTransferIds = new Set<string>();
+  // metric series of this reporter, resolved once
+  metrics: ReturnType<typeof createMetrics>;
 
   constructor(networkName: NetworkName) {
     this.network = networkName;
+    this.metrics = createMetrics(networkName);
+    this.state = new ReporterState(networkName, SETTLE_MS);
+    this.eventLog = getEventLog(
+      networkName,
+      getContractsForNetwork(networkName).ibc
+    );
+    if (this.eventLog && this.state.events)
+      this.eventLog.restore(this.state.events);
+    this.reportPipeline = new SubmissionPipeline<TTransfersRowTransformed>({
+      key: (t) => this.getInternalUniqueTransferId(t),
+      submit: (transfers) => this.submitReports(transfers),
+      maxInFlight: MAX_IN_FLIGHT,
+      maxBatchSize: MAX_ACTIONS_PER_TX,
+      batchBudget: TX_CPU_BUDGET_US,
+      cost: () => ACTION_CPU_ESTIMATE_US.report,
+      settleMs: SETTLE_MS,
+      onSubmitted: (transfers) =>
+        this.state.recordSent(
+          transfers.map((t) => `report:${this.getInternalUniqueTransferId(t)}`)
+        ),
+      onFailure: (t, error) => {
+        this.countFailures(this.metrics.report, 1, error);
+        this.onSubmitError(
+          `report transfer ${this.getInternalUniqueTransferId(t)}`,
+          error
+        );
+      },
+      onError: (transfers, error) => {
+        if (!isActionFailure(error))
+          this.countFailures(this.metrics.report, transfers.length, error);
+        this.onSubmitError(`report ${transfers.length} transfer(s)`, error);
+      },
+    });
+    this.execPipeline = new SubmissionPipeline<TReportsRowTransformed>({
+      key: (r) => `${r.id}`,
+      submit: (reports) => this.submitExecs(reports),
+      maxInFlight: MAX_IN_FLIGHT,
+      maxBatchSize: MAX_ACTIONS_PER_TX,
+      batchBudget: TX_CPU_BUDGET_US,
+      cost: () => ACTION_CPU_ESTIMATE_US.exec,
+      settleMs: SETTLE_MS,
+      onSubmitted: (reports) =>
+        this.state.recordSent(reports.map((r) => `exec:${r.id}`)),
+      onFailure: (r, error) => {
+        // another reporter executed or failed it first, nothing to refund
+        if (isDuplicateError(error)) {
+          this.metrics.exec.duplicate.inc();
+          this.log(`info`, `Report-id ${r.id} was already settled`);
+          return;
+        }
+        this.metrics.exec.failed.inc();
+        return this.submitExecFailed(r, error);
+      },
+      onError: (reports, error) => {
+        if (!isActionFailure(error))
+          this.countFailures(this.metrics.exec, reports.length, error);
+        this.onSubmitError(`execute ${reports.length} report(s)`, error);
+      },
+    });
+
+    // transactions sent right before a restart are not sent again
+    Object.keys(this.state.sent).forEach((key) => {
+      const [pipeline, itemKey] = [
+        key.slice(0, key.indexOf(`:`)),
+        key.slice(key.indexOf(`:`) + 1),
+      ];
+      if (pipeline === `report`)
+        this.reportPipeline.markSettled(itemKey, this.state.sent[key]);
+      else if (pipeline === `exec`)
+        this.execPipeline.markSettled(itemKey, this.state.sent[key]);
+    });
   }
 
   log(level: string, ...args) {
@@ -41,9 +174,18 @@ export default class Reporter {
 
   public async start() {
     this.log(`info`, `started`);
+    // warm the ABI and TAPOS caches before the first submission
+    Promise.all([
+      getActionTemplates(this.xChainNetwork),
+      getTapos(this.xChainNetwork),
+    ]).catch((error) =>
+      this.log(`warn`, `Could not warm caches: ${extractRpcError(error)}`)
+    );
 
     while (true) {
       try {
+        this.pollCount += 1;
+        const observePoll = this.metrics.poll.startTimer();
         await Promise.race([
           Promise.all([
             this.fetchTransfers(),
@@ -58,6 +200,7 @@ export default class Reporter {
 
         await this.reportTransfers();
         await this.executeReports();
+        observePoll();
       } catch (error) {
         this.log(`error`, extractRpcError(error));
         pulseError(this.network, extractRpcError(error))
@@ -68,34 +211,133 @@ export default class Reporter {
   }
 
   async fetchTransfers() {
+    if (this.eventLog) {
+      if (!this.transfersTableLoaded) {
+        await this.fetchTransfersTable();
+        this.transfersTableLoaded = true;
+      }
+      return this.ingestTransferEvents();
+    }
+    return this.fetchTransfersTable();
+  }
+
+  private async fetchTransfersTable() {
     const contracts = getContractsForNetwork(this.network);
-    let transfers = await fetchAllRows(this.network)<TTransfersRow>({
-      code: contracts.ibc,
-      scope: contracts.ibc,
-      table: `transfers`,
-      lower_bound: Math.floor(Date.now() / 1e3),
-      index_position: `2`,
-      key_type: `i64`,
+    const fullSync = this.isFullSync;
+    // transfer rows never change, only new ones need to be fetched
+    const transfers = await fetchAllRows(this.network)<TTransfersRow>(
+      fullSync
+        ? {
+            code: contracts.ibc,
+            scope: contracts.ibc,
+            table: `transfers`,
+            lower_bound: Math.floor(Date.now() / 1e3),
+            index_position: `2`,
+            key_type: `i64`,
+          }
+        : {
+            code: contracts.ibc,
+            scope: contracts.ibc,
+            table: `transfers`,
+            lower_bound: this.transfersWatermark + 1,
+          }
+    );
+
+    if (fullSync) this.transfers.clear();
+    transfers.forEach((row) => {
+      const transfer = transformTransfer(row);
+      this.transfers.set(this.getInternalUniqueTransferId(transfer), transfer);
+      this.transfersWatermark = Math.max(this.transfersWatermark, transfer.id);
     });
+    this.evictExpiredTransfers();
+  }
+
+  // every evtransfer is seen exactly once, only new transfers are appended
+  async ingestTransferEvents() {
+    const events = await this.eventLog.poll();
 
-    this.transfers = transfers.map((t) => ({
-      ...t,
-      id: Number.parseInt(`${t.id}`, 10),
-      is_refund: Boolean(t.is_refund),
-      // do not overwrite original transaction_time and expires_at
-      // if a Date object is serialized back using eosjs, it will _not_ equal
-      // the original strings because of time zones
-      // new Date(Date.parse(a + 'Z')) https://github.com/EOSIO/eosjs/blob/master/src/eosjs-serialize.ts#L540
-      // they should do: new Date(Date.parse(a.toISOString()))
-      transactionDate: new Date(`${t.transaction_time}Z`),
-      expiresAtDate: new Date(`${t.expires_at}Z`),
-    }));
+    events.forEach((event) => {
+      if (event.name !== `evtransfer`) return;
+      const transfer = transformTransfer(event.data.transfer);
+      this.transfers.set(this.getInternalUniqueTransferId(transfer), transfer);
+    });
+    this.state.recordEventCheckpoint(this.eventLog.checkpoint());
+    this.evictExpiredTransfers();
+  }
+
+  private evictExpiredTransfers() {
+    const now = Date.now();
+    this.transfers.forEach((t, key) => {
+      if (t.expiresAtDate.getTime() <= now) this.transfers.delete(key);
+    });
+    this.irreversibleTransferIds.forEach((key) => {
+      if (!this.transfers.has(key)) this.irreversibleTransferIds.delete(key);
+    });
+    this.state.evictExpired(now);
   }
 
   async fetchXReports() {
+    if (this.isFullSync || this.reportsResync) return this.syncXReports();
+
     const xChainNetwork = this.xChainNetwork;
     const contracts = getContractsForNetwork(xChainNetwork);
-    const reports = await fetchAllRows(xChainNetwork)<TReportsRow>({
+    const table = {
+      code: contracts.ibc,
+      scope: contracts.ibc,
+      table: `reports`,
+    };
+    const ranges = this.pendingReportRanges();
+    const [newRows, ...rangeRows] = await Promise.all([
+      // starts at the watermark row itself to notice it being erased
+      fetchAllRows(xChainNetwork)<TReportsRow>({
+        ...table,
+        lower_bound: Math.max(0, this.reportsWatermark),
+      }),
+      ...ranges.map(([lower, upper]) =>
+        fetchAllRows(xChainNetwork)<TReportsRow>({
+          ...table,
+          lower_bound: lower,
+          upper_bound: upper,
+        })
+      ),
+    ]);
+
+    // available_primary_key() reuses the ids of erased rows at the top of
+    // the table, new reports could then sit below the watermark
+    if (this.reportsWatermark >= 0) {
+      const first = newRows[0];
+      const known = this.reports.get(this.reportsWatermark);
+      if (
+        !first ||
+        toId(first) !== this.reportsWatermark ||
+        (known &&
+          this.getInternalUniqueTransferId(first.transfer as any) !==
+            this.getInternalUniqueTransferId(known.transfer as any))
+      ) {
+        this.log(
+          `info`,
+          `Report ${this.reportsWatermark} was erased, re-syncing reports`
+        );
+        this.reportsResync = true;
+        return this.syncXReports();
+      }
+    }
+
+    // pending reports missing from their range were erased
+    ranges.forEach(([lower, upper], i) => {
+      const ids = new Set(rangeRows[i].map(toId));
+      this.reports.forEach((r, id) => {
+        if (id >= lower && id <= upper && !ids.has(id)) this.deleteReport(id);
+      });
+    });
+    rangeRows.forEach((rows) => this.applyReports(rows, this.reports));
+    this.applyReports(newRows, this.reports);
+    this.deleteExpiredReports();
+  }
+
+  private async syncXReports() {
+    const contracts = getContractsForNetwork(this.xChainNetwork);
+    const reports = await fetchAllRows(this.xChainNetwork)<TReportsRow>({
       code: contracts.ibc,
       scope: contracts.ibc,
       table: `reports`,
@@ -103,10 +345,115 @@ export default class Reporter {
       index_position: `3`,
       key_type: `i64`,
     });
-    this.reports = reports.map((r) => ({
-      ...r,
-      id: Number.parseInt(`${r.id}`, 10),
-    }));
+
+    const previous = this.reports;
+    this.reports = new Map();
+    this.reportedTransferIds.clear();
+    this.reportsFetchedAt.clear();
+    this.reportsWatermark = -1;
+    this.reportsResync = false;
+    this.applyReports(reports, previous);
+    this.deleteExpiredReports();
+  }
+
+  // executed and failed reports are final, the others are refreshed in ranges
+  // of at most PENDING_RANGE_SPAN ids: the newest range on every poll, an
+  // older one (e.g. a report that never gets confirmed) while one of its
+  // reports is in flight or settling, or once its state is PENDING_MAX_AGE_MS
+  // old
+  private pendingReportRanges() {
+    const now = Date.now();
+    const pending: number[] = [];
+    this.reports.forEach((r, id) => {
+      if (!r.executed && !r.failed) pending.push(id);
+    });
+    pending.sort((a, b) => a - b);
+
+    const ranges: [number, number][] = [];
+    const due: boolean[] = [];
+    pending.forEach((id) => {
+      const last = ranges[ranges.length - 1];
+      if (last && id - last[0] < PENDING_RANGE_SPAN) {
+        last[1] = id;
+      } else {
+        ranges.push([id, id]);
+        due.push(false);
+      }
+      due[due.length - 1] = due[due.length - 1] || this.isReportDue(id, now);
+    });
+    if (ranges.length <= 1) return ranges;
+
+    const newest = ranges.pop();
+    return ranges.filter((_, i) => due[i]).concat([newest]);
+  }
+
+  private isReportDue(id: number, now: number) {
+    const report = this.reports.get(id);
+    return (
+      now - (this.reportsFetchedAt.get(id) || 0) >= PENDING_MAX_AGE_MS ||
+      this.execPipeline.isActive(`${id}`) ||
+      this.reportPipeline.isActive(
+        this.getInternalUniqueTransferId(report.transfer as any)
+      )
+    );
+  }
+
+  private applyReports(
+    reports: TReportsRow[],
+    previous: Map<number, TReportsRowTransformed>
+  ) {
+    const { reporterAccount } = getContractsForNetwork(this.xChainNetwork);
+    const now = Date.now();
+    reports.forEach((r) => {
+      const id = toId(r);
+      this.observeSettlement(previous.get(id), r);
+      this.reports.set(id, { ...r, id });
+      this.reportsFetchedAt.set(id, now);
+      this.reportsWatermark = Math.max(this.reportsWatermark, id);
+      if (r.confirmed_by.indexOf(reporterAccount) !== -1)
+        this.reportedTransferIds.add(
+          this.getInternalUniqueTransferId(r.transfer as any)
+        );
+    });
+  }
+
+  private deleteReport(id: number) {
+    const report = this.reports.get(id);
+    if (!report) return;
+    this.reports.delete(id);
+    this.reportsFetchedAt.delete(id);
+    this.reportedTransferIds.delete(
+      this.getInternalUniqueTransferId(report.transfer as any)
+    );
+  }
+
+  // a report expires together with its transfer, compare the UTC strings
+  // "2020-05-21T11:29:56" directly instead of parsing every row
+  private deleteExpiredReports() {
+    const now = new Date().toISOString().slice(0, 19);
+    this.reports.forEach((r, id) => {
+      if (r.transfer.expires_at <= now) this.deleteReport(id);
+    });
+  }
+
+  // reports that were already settled before the first poll are not observed
+  private observeSettlement(
+    previous: TReportsRowTransformed,
+    report: TReportsRow
+  ) {
+    if (!previous && this.pollCount === 1) return;
+    const seconds =
+      (Date.now() - Date.parse(`${report.transfer.transaction_time}Z`)) / 1e3;
+    if (report.confirmed && !(previous && previous.confirmed))
+      this.metrics.confirmed.observe(seconds);
+    if (report.executed && !(previous && previous.executed))
+      this.metrics.executed.observe(seconds);
+  }
+
+  // transfer rows deleted manually are only noticed by a full sync of all
+  // non-expired rows
+  private get isFullSync() {
+    return (this.pollCount - 1) % FULL_SYNC_INTERVAL === 0;
   }
 
   async fetchHeadBlockNumbers() {
@@ -121,108 +468,96 @@ export default class Reporter {
   }
 
   private async reportTransfers() {
-    const unreportedTransfers = this.transfers.filter((t) => {
-      const isExpired = Date.now() > t.expiresAtDate.getTime();
-      if (isExpired) return false;
+    const now = Date.now();
+    const unreportedTransfers: TTransfersRowTransformed[] = [];
+    this.transfers.forEach((t, tId) => {
+      const isExpired = now > t.expiresAtDate.getTime();
+      // reports are only fetched from the x-chain
+      if (t.to_blockchain !== this.xChainNetwork) return;
+      if (isExpired || this.reportedTransferIds.has(tId)) return;
 
-      if (!isNetworkName(t.to_blockchain))
-        throw new Error(
-          `Unknwon blockchain in transfer with id ${t.id}: ${t.to_blockchain}`
-        );
-      const xcontracts = getContractsForNetwork(t.to_blockchain);
-
-      const alreadyReported = this.reports.some((r) => {
-        return (
-          r.transfer.id === t.id &&
-          r.transfer.from_blockchain === t.from_blockchain &&
-          r.transfer.transaction_id === t.transaction_id &&
-          r.confirmed_by.includes(xcontracts.reporterAccount)
-        );
-      });
-
-      return !alreadyReported;
+      unreportedTransfers.push(t);
     });
-    if (unreportedTransfers.length === 0) return;
 
     const irreversibleUnreportedTransfers = await this.filterTransfersByIrreversibility(
       unreportedTransfers
     );
-    if (irreversibleUnreportedTransfers.length === 0) return;
+    this.reportPipeline.enqueue(irreversibleUnreportedTransfers);
 
-    const transferToProcess = pickRandom(irreversibleUnreportedTransfers);
+    this.metrics.backlog.transfers.set(this.transfers.size);
+    this.metrics.backlog.irreversibility.set(
+      unreportedTransfers.length - irreversibleUnreportedTransfers.length
+    );
+    this.metrics.backlog.reportQueue.set(this.reportPipeline.backlog);
+    this.metrics.backlog.reportInFlight.set(this.reportPipeline.pending);
+  }
 
-    const toBlockchain = transferToProcess.to_blockchain;
+  // all transfers of a batch go to the same chain, the x-chain of this reporter
+  private async submitReports(transfers: TTransfersRowTransformed[]) {
+    const toBlockchain = transfers[0].to_blockchain;
     if (!isNetworkName(toBlockchain))
       throw new Error(
-        `Unknwon blockchain in transfer with id ${transferToProcess.id}: ${toBlockchain}`
+        `Unknwon blockchain in transfer with id ${transfers[0].id}: ${toBlockchain}`
       );
 
-    const xcontracts = getContractsForNetwork(toBlockchain);
-    try {
-      const tx = await sendTransaction(toBlockchain)({
-        account: xcontracts.ibc,
-        name: `report`,
-        authorization: [
-          {
-            actor: xcontracts.reporterAccount,
-            permission: xcontracts.reporterPermission,
-          },
-        ],
-        data: {
-          reporter: xcontracts.reporterAccount,
-          transfer: transferToProcess,
-        },
-      });
-      this.log(
-        `info`,
-        `Reported transfer with id ${this.getInternalUniqueTransferId(
-          transferToProcess
-        )}: ${formatBloksTransaction(toBlockchain, tx.transaction_id)}`
-      );
-    } catch (error) {
-      // const errorMessage = extractRpcError(error)
-      throw error;
-    }
+    const templates = await getActionTemplates(toBlockchain);
+    const observeSubmission = this.metrics.report.duration.startTimer();
+    const tx = await sendTransaction(toBlockchain)(
+      transfers.map((transferToProcess) =>
+        templates.report.serialize({ transfer: transferToProcess })
+      )
+    );
+    observeSubmission();
+    this.metrics.report.submitted.inc(transfers.length);
+    this.log(
+      `info`,
+      `Reported transfers with ids ${transfers
+        .map((t) => this.getInternalUniqueTransferId(t))
+        .join(`, `)}: ${formatBloksTransaction(
+        toBlockchain,
+        tx.transaction_id
+      )}`
+    );
   }
 
   private async executeReports() {
-    const reportsToExecute = this.reports.filter((r) => {
-      const reporterName = getContractsForNetwork(
-        r.transfer.to_blockchain as NetworkName
-      ).reporterAccount;
-      return (
+    const reporterName = getContractsForNetwork(this.xChainNetwork)
+      .reporterAccount;
+    const reportsToExecute: TReportsRowTransformed[] = [];
+    this.reports.forEach((r) => {
+      if (
         r.confirmed &&
         !r.executed &&
         !r.failed &&
-        !r.failed_by.includes(reporterName)
-      );
+        r.failed_by.indexOf(reporterName) === -1
+      )
+        reportsToExecute.push(r);
     });
-    if (reportsToExecute.length === 0) return;
 
-    const reportToExecute = pickRandom(reportsToExecute);
-    const toBlockchain = reportToExecute.transfer.to_blockchain;
+    // different order for every reporter to avoid executing the same report
+    this.execPipeline.enqueue(shuffle(reportsToExecute));
+
+    this.metrics.backlog.execQueue.set(this.execPipeline.backlog);
+    this.metrics.backlog.execInFlight.set(this.execPipeline.pending);
+  }
+
+  private async submitExecs(reports: TReportsRowTransformed[]) {
+    const toBlockchain = reports[0].transfer.to_blockchain;
     if (!isNetworkName(toBlockchain))
       throw new Error(
-        `Unknwon blockchain in reported transfer with id ${reportToExecute.id}: ${toBlockchain}`
+        `Unknwon blockchain in reported transfer with id ${reports[0].id}: ${toBlockchain}`
       );
 
-    const xcontracts = getContractsForNetwork(toBlockchain);
-    let executionFailed = false;
-    try {
-      const tx = await sendTransaction(toBlockchain)({
-        account: xcontracts.ibc,
-        name: `exec`,
-        authorization: [
-          {
-            actor: xcontracts.reporterAccount,
-            permission: xcontracts.reporterPermission,
-          },
-        ],
-        data: {
-          reporter: xcontracts.reporterAccount,
-          report_id: reportToExecute.id,
-        },
-      });
+    const templates = await getActionTemplates(toBlockchain);
+    const observeSubmission = this.metrics.exec.duration.startTimer();
+    const tx = await sendTransaction(toBlockchain)(
+      reports.map((reportToExecute) =>
+        templates.exec.serialize({ report_id: reportToExecute.id })
+      )
+    );
+    observeSubmission();
+    this.metrics.exec.submitted.inc(reports.length);
+    reports.forEach((reportToExecute) =>
       this.log(
         `info`,
         `Executed report-id ${
@@ -230,36 +565,39 @@ export default class Reporter {
         } (transfer ${this.getInternalUniqueTransferId(
           reportToExecute.transfer as any
         )}): ${formatBloksTransaction(toBlockchain, tx.transaction_id)}`
+      )
+    );
+  }
+
+  // exec failed on its own, not because of other actions in its transaction
+  private async submitExecFailed(
+    reportToExecute: TReportsRowTransformed,
+    error: any
+  ) {
+    const errorMessage = extractRpcError(error);
+    this.log(
+      `error`,
+      `Could not execute report-id ${
+        reportToExecute.id
+      } (transfer ${this.getInternalUniqueTransferId(
+        reportToExecute.transfer as any
+      )}): ${errorMessage}`
+    );
+
+    const toBlockchain = reportToExecute.transfer.to_blockchain as NetworkName;
+    const templates = await getActionTemplates(toBlockchain);
+    const observeSubmission = this.metrics.execfailed.duration.startTimer();
+    let tx: TTransactionResult;
+    try {
+      tx = await sendTransaction(toBlockchain)(
+        templates.execfailed.serialize({ report_id: reportToExecute.id })
       );
-    } catch (error) {
-      const errorMessage = extractRpcError(error);
-      this.log(
-        `error`,
-        `Could not execute report-id ${
-          reportToExecute.id
-        } (transfer ${this.getInternalUniqueTransferId(
-          reportToExecute.transfer as any
-        )}): ${errorMessage}`
-      );
-      executionFailed = true;
+    } catch (execFailedError) {
+      this.countFailures(this.metrics.execfailed, 1, execFailedError);
+      throw execFailedError;
     }
-
-    if (!executionFailed) return;
-
-    const tx = await sendTransaction(toBlockchain)({
-      account: xcontracts.ibc,
-      name: `execfailed`,
-      authorization: [
-        {
-          actor: xcontracts.reporterAccount,
-          permission: xcontracts.reporterPermission,
-        },
-      ],
-      data: {
-        reporter: xcontracts.reporterAccount,
-        report_id: reportToExecute.id,
-      },
-    });
+    observeSubmission();
+    this.metrics.execfailed.submitted.inc();
     this.log(
       `info`,
       `Reported failed execution for ${
@@ -268,36 +606,76 @@ export default class Reporter {
     );
   }
 
+  private countFailures(
+    action: ReturnType<typeof createMetrics>["report"],
+    count: number,
+    error: any
+  ) {
+    if (isDuplicateError(error)) action.duplicate.inc(count);
+    else action.failed.inc(count);
+  }
+
+  private onSubmitError(description: string, error: any) {
+    const errorMessage = extractRpcError(error);
+    this.log(`error`, `Could not ${description}: ${errorMessage}`);
+    pulseError(this.network, errorMessage);
+  }
+
   private async filterTransfersByIrreversibility(
     transfers: TTransfersRowTransformed[]
   ): Promise<TTransfersRowTransformed[]> {
     // because rpc.history_get_transaction is deprecated, there's no way for us to get the exact block number of when the transaction was included
     // but when we see it in RAM, the current head block is definitely past it
+    const now = Date.now();
+    const newlySeen: {
+      id: string;
+      block: number;
+      at: number;
+      exp: number;
+    }[] = [];
     transfers.forEach((t) => {
       const tId = this.getInternalUniqueTransferId(t);
-      if (!this.transferIrreversibilityMap[tId]) {
+      if (!this.state.firstSeen[tId]) {
         const txInfo = `${t.from_account}@${t.from_blockchain} == ${t.quantity} ==> ${t.to_account}@${t.to_blockchain}`;
         this.log(
           `info`,
           `Saw new transfer ${tId} at block ${this.currentHeadBlock}\n${txInfo}\nWaiting for irreversibility`
         );
         // saw at headblock, wait until this block becomes irreversible
-        this.transferIrreversibilityMap[tId] = this.currentHeadBlock;
+        newlySeen.push({
+          id: tId,
+          block: this.currentHeadBlock,
+          at: now,
+          exp: t.expiresAtDate.getTime(),
+        });
       }
     });
+    this.state.recordFirstSeen(newlySeen);
 
-    return transfers.filter(
-      (t) =>
-        this.currentIrreversibleHeadBlock >
-        (this.transferIrreversibilityMap[this.getInternalUniqueTransferId(t)] ||
-          Infinity)
-    );
+    return transfers.filter((t) => {
+      const tId = this.getInternalUniqueTransferId(t);
+      const seen = this.state.firstSeen[tId];
+      const isIrreversible =
+        this.currentIrreversibleHeadBlock > (seen ? seen.block : Infinity);
+      // only transfers first seen by this process, not the restored ones
+      if (
+        isIrreversible &&
+        seen.at >= this.startedAt &&
+        !this.irreversibleTransferIds.has(tId)
+      ) {
+        this.irreversibleTransferIds.add(tId);
+        this.metrics.irreversible.observe((now - seen.at) / 1e3);
+      }
+      return isIrreversible;
+    });
   }
 
   private getInternalUniqueTransferId(transfer: TTransfersRowTransformed) {
     return `${transfer.from_blockchain}|${transfer.id}|${transfer.transaction_id}`;
   }
 
+  // the reporter only bridges eos and wax, the contracts accept more peers
+  // but reporting them needs a network config per peer
   private get xChainNetwork(): NetworkName {
     switch (this.network) {
       case `eos`:
@@ -321,3 +699,49 @@ export default class Reporter {
     // );
   }
 }
+
+const toId = (row: { id: number | string }) =>
+  Number.parseInt(`${row.id}`, 10);
+
+const transformTransfer = (t: TTransfersRow): TTransfersRowTransformed => ({
+  ...t,
+  id: Number.parseInt(`${t.id}`, 10),
+  is_refund: Boolean(t.is_refund),
+  // do not overwrite original transaction_time and expires_at
+  // if a Date object is serialized back using eosjs, it will _not_ equal
+  // the original strings because of time zones
+  // new Date(Date.parse(a + 'Z')) https://github.com/EOSIO/eosjs/blob/master/src/eosjs-serialize.ts#L540
+  // they should do: new Date(Date.parse(a.toISOString()))
+  transactionDate: new Date(`${t.transaction_time}Z`),
+  expiresAtDate: new Date(`${t.expires_at}Z`),
+});
+
+const createMetrics = (network: NetworkName) => {
+  const action = (name: string) => ({
+    duration: metrics.submissionDuration.labels(network, name),
+    submitted: metrics.transactions.labels(network, name, `submitted`),
+    failed: metrics.transactions.labels(network, name, `failed`),
+    duplicate: metrics.transactions.labels(network, name, `duplicate`),
+  });
+
+  return {
+    poll: metrics.pollDuration.labels(network),
+    irreversible: metrics.irreversibleDelay.labels(network),
+    confirmed: metrics.settlementDelay.labels(network, `confirmed`),
+    executed: metrics.settlementDelay.labels(network, `executed`),
+    report: action(`report`),
+    exec: action(`exec`),
+    execfailed: action(`execfailed`),
+    backlog: {
+      transfers: metrics.backlog.labels(network, `transfers`),
+      irreversibility: metrics.backlog.labels(
+        network,
+        `awaiting_irreversibility`
+      ),
+      reportQueue: metrics.backlog.labels(network, `report_queue`),
+      reportInFlight: metrics.backlog.labels(network, `report_in_flight`),
+      execQueue: metrics.backlog.labels(network, `exec_queue`),
+      execInFlight: metrics.backlog.labels(network, `exec_in_flight`),
+    },
+  };
+};
@@ -1,5 +1,6 @@
 import HealthController from "./controller/HealthController";
 import LogController from "./controller/LogController";
+import MetricsController from "./controller/MetricsController";
 
 export const Routes = [
     {
@@ -14,4 +15,10 @@ export const Routes = [
         controller: LogController,
         action: "logs"
     },
+    {
+        method: "get",
+        route: "/metrics",
+        controller: MetricsController,
+        action: "metrics"
+    },
 ];
\ No newline at end of file
@@ -48,6 +48,18 @@ export const pickRandom = <T>(array: T[]):T => {
   return array[Math.floor(Math.random() * array.length)];
 };
 
+// Fisher-Yates, returns a shuffled copy
+export const shuffle = <T>(array: T[]): T[] => {
+  const copy = array.slice();
+  for (let i = copy.length - 1; i > 0; i -= 1) {
+    const j = Math.floor(Math.random() * (i + 1));
+    const tmp = copy[i];
+    copy[i] = copy[j];
+    copy[j] = tmp;
+  }
+  return copy;
+};
+
 export const extractRpcError = (err: Error|RpcError|any) => {
   let message = err.message
   if(err instanceof RpcError) {
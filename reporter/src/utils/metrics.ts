@@ -0,0 +1,220 @@
+// Prometheus metrics, rendered in the text exposition format on /metrics.
+// Series are created once per label combination and then updated in place,
+// observing a value does not allocate.
+
+type TLabels = string[];
+
+const escapeLabel = (value: string) =>
+  value.replace(/\\/g, `\\\\`).replace(/"/g, `\\"`).replace(/\n/g, `\\n`);
+
+const formatLabels = (names: string[], values: TLabels, extra = ``) => {
+  const pairs = names.map((name, i) => `${name}="${escapeLabel(values[i])}"`);
+  if (extra) pairs.push(extra);
+  return pairs.length > 0 ? `{${pairs.join(`,`)}}` : ``;
+};
+
+abstract class Metric<TSeries> {
+  name: string;
+  help: string;
+  labelNames: string[];
+  protected series: { [key: string]: { labels: TLabels; series: TSeries } } = {};
+
+  constructor(name: string, help: string, labelNames: string[]) {
+    this.name = name;
+    this.help = help;
+    this.labelNames = labelNames;
+    registry.push(this);
+  }
+
+  // callers on hot paths should keep the returned series
+  labels(...values: TLabels): TSeries {
+    const key = values.join(`\u0000`);
+    let entry = this.series[key];
+    if (!entry) {
+      entry = { labels: values, series: this.createSeries() };
+      this.series[key] = entry;
+    }
+    return entry.series;
+  }
+
+  protected abstract createSeries(): TSeries;
+  protected abstract renderSeries(labels: TLabels, series: TSeries): string[];
+  protected abstract readonly type: string;
+
+  render() {
+    const lines = [
+      `# HELP ${this.name} ${this.help}`,
+      `# TYPE ${this.name} ${this.type}`,
+    ];
+    Object.keys(this.series).forEach((key) => {
+      const { labels, series } = this.series[key];
+      lines.push(...this.renderSeries(labels, series));
+    });
+    return lines.join(`\n`);
+  }
+}
+
+export class CounterSeries {
+  value = 0;
+  inc(by = 1) {
+    this.value += by;
+  }
+}
+
+export class Counter extends Metric<CounterSeries> {
+  protected readonly type = `counter`;
+  protected createSeries() {
+    return new CounterSeries();
+  }
+  protected renderSeries(labels: TLabels, series: CounterSeries) {
+    return [
+      `${this.name}${formatLabels(this.labelNames, labels)} ${series.value}`,
+    ];
+  }
+}
+
+export class GaugeSeries {
+  value = 0;
+  set(value: number) {
+    this.value = value;
+  }
+}
+
+export class Gauge extends Metric<GaugeSeries> {
+  protected readonly type = `gauge`;
+  protected createSeries() {
+    return new GaugeSeries();
+  }
+  protected renderSeries(labels: TLabels, series: GaugeSeries) {
+    return [
+      `${this.name}${formatLabels(this.labelNames, labels)} ${series.value}`,
+    ];
+  }
+}
+
+export class HistogramSeries {
+  buckets: number[];
+  // per bucket, not cumulative; the last slot is +Inf
+  counts: Float64Array;
+  sum = 0;
+  count = 0;
+
+  constructor(buckets: number[]) {
+    this.buckets = buckets;
+    this.counts = new Float64Array(buckets.length + 1);
+  }
+
+  observe(value: number) {
+    let i = 0;
+    while (i < this.buckets.length && value > this.buckets[i]) i += 1;
+    this.counts[i] += 1;
+    this.sum += value;
+    this.count += 1;
+  }
+
+  // returns a function that observes the seconds elapsed since this call
+  startTimer() {
+    const start = Date.now();
+    return () => this.observe((Date.now() - start) / 1e3);
+  }
+}
+
+export class Histogram extends Metric<HistogramSeries> {
+  buckets: number[];
+
+  constructor(
+    name: string,
+    help: string,
+    labelNames: string[],
+    buckets: number[]
+  ) {
+    super(name, help, labelNames);
+    this.buckets = buckets;
+  }
+
+  protected readonly type = `histogram`;
+  protected createSeries() {
+    return new HistogramSeries(this.buckets);
+  }
+  protected renderSeries(labels: TLabels, series: HistogramSeries) {
+    const lines: string[] = [];
+    let cumulative = 0;
+    this.buckets.forEach((le, i) => {
+      cumulative += series.counts[i];
+      lines.push(
+        `${this.name}_bucket${formatLabels(
+          this.labelNames,
+          labels,
+          `le="${le}"`
+        )} ${cumulative}`
+      );
+    });
+    lines.push(
+      `${this.name}_bucket${formatLabels(
+        this.labelNames,
+        labels,
+        `le="+Inf"`
+      )} ${series.count}`
+    );
+    lines.push(
+      `${this.name}_sum${formatLabels(this.labelNames, labels)} ${series.sum}`
+    );
+    lines.push(
+      `${this.name}_count${formatLabels(this.labelNames, labels)} ${
+        series.count
+      }`
+    );
+    return lines;
+  }
+}
+
+const registry: Metric<any>[] = [];
+
+export const renderMetrics = () =>
+  `${registry.map((metric) => metric.render()).join(`\n`)}\n`;
+
+// request latencies in seconds
+const LATENCY_BUCKETS = [0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10];
+// stages measured against block times, in seconds
+const STAGE_BUCKETS = [1, 2, 5, 10, 30, 60, 120, 300, 600, 1800, 3600];
+
+export const pollDuration = new Histogram(
+  `ibc_poll_duration_seconds`,
+  `Duration of a reporter poll: fetching tables and queueing actions`,
+  [`network`],
+  LATENCY_BUCKETS
+);
+export const rpcDuration = new Histogram(
+  `ibc_rpc_request_duration_seconds`,
+  `Latency of RPC requests per endpoint and API path`,
+  [`endpoint`, `path`],
+  LATENCY_BUCKETS
+);
+export const irreversibleDelay = new Histogram(
+  `ibc_transfer_irreversible_seconds`,
+  `Time from first seeing a transfer to its block becoming irreversible`,
+  [`network`],
+  STAGE_BUCKETS
+);
+export const submissionDuration = new Histogram(
+  `ibc_submission_duration_seconds`,
+  `Time to push a transaction until the node accepted it`,
+  [`network`, `action`],
+  LATENCY_BUCKETS
+);
+export const settlementDelay = new Histogram(
+  `ibc_settlement_seconds`,
+  `Time from the transfer transaction to its report being confirmed / executed`,
+  [`network`, `stage`],
+  STAGE_BUCKETS
+);
+export const transactions = new Counter(
+  `ibc_transactions_total`,
+  `Actions sent by this reporter, by outcome: submitted, failed, duplicate`,
+  [`network`, `action`, `outcome`]
+);
+export const backlog = new Gauge(
+  `ibc_backlog`,
+  `Items waiting in each stage of the reporter`,
+  [`network`, `stage`]
+);
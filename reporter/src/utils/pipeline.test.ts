@@ -0,0 +1,170 @@
+import { RpcError } from "eosjs";
+import SubmissionPipeline from "./pipeline";
+
+const rpcError = (name: string, message: string) =>
+  new RpcError({
+    code: 500,
+    message: `Internal Service Error`,
+    error: { code: 3050003, name, what: message, details: [{ message }] },
+  });
+const assertFailure = () =>
+  rpcError(
+    `eosio_assert_message_exception`,
+    `assertion failure with message: not confirmed yet`
+  );
+const cpuExceeded = () =>
+  rpcError(`tx_cpu_usage_exceeded`, `billed CPU time is greater than maximum`);
+
+const flush = () => new Promise((resolve) => setImmediate(resolve));
+const waitFor = async (condition: () => boolean) => {
+  for (let i = 0; i < 100 && !condition(); i += 1) {
+    await flush();
+  }
+  expect(condition()).toBe(true);
+};
+
+type TCall = {
+  items: string[];
+  resolve: () => void;
+  reject: (error: any) => void;
+};
+
+// a pipeline whose transactions are settled by the test, or right away by
+// `respond` if given
+const createPipeline = (
+  options: {
+    maxInFlight?: number;
+    maxBatchSize?: number;
+    settleMs?: number;
+    respond?: (items: string[]) => Promise<void>;
+  } = {}
+) => {
+  const calls: TCall[] = [];
+  const failures: string[] = [];
+  const errors: { items: string[]; error: any }[] = [];
+  const pipeline = new SubmissionPipeline<string>({
+    key: (item) => item,
+    submit: (items) => {
+      if (options.respond) {
+        calls.push({ items, resolve: null, reject: null });
+        return options.respond(items);
+      }
+      return new Promise<void>((resolve, reject) =>
+        calls.push({ items, resolve, reject })
+      );
+    },
+    maxInFlight: options.maxInFlight || 2,
+    maxBatchSize: options.maxBatchSize || 10,
+    batchBudget: 10,
+    cost: () => 1,
+    settleMs: options.settleMs || 60 * 1e3,
+    onFailure: (item) => {
+      failures.push(item);
+    },
+    onError: (items, error) => errors.push({ items, error }),
+  });
+  return { pipeline, calls, failures, errors };
+};
+
+const items = (count: number, prefix = `t`) =>
+  Array.from({ length: count }, (_, i) => `${prefix}${i}`);
+
+describe("SubmissionPipeline", () => {
+  it("packs items into batches within the in-flight window", async () => {
+    const { pipeline, calls } = createPipeline({ maxInFlight: 2 });
+
+    pipeline.enqueue(items(25));
+    expect(calls.map((c) => c.items.length)).toEqual([10, 10]);
+    expect(pipeline.backlog).toEqual(5);
+
+    calls[0].resolve();
+    await waitFor(() => calls.length === 3);
+    expect(calls[2].items).toEqual(items(25).slice(20));
+    expect(pipeline.pending).toEqual(2);
+  });
+
+  it("bisects a batch that failed a contract check", async () => {
+    const { pipeline, calls, failures, errors } = createPipeline({
+      maxInFlight: 1,
+      respond: (batch) =>
+        batch.indexOf(`t2`) === -1
+          ? Promise.resolve()
+          : Promise.reject(assertFailure()),
+    });
+
+    pipeline.enqueue(items(4));
+    await waitFor(() => pipeline.pending === 0);
+
+    expect(calls.map((c) => c.items)).toEqual([
+      [`t0`, `t1`, `t2`, `t3`],
+      [`t0`, `t1`],
+      [`t2`, `t3`],
+      [`t2`],
+      [`t3`],
+    ]);
+    expect(failures).toEqual([`t2`]);
+    expect(errors).toEqual([]);
+  });
+
+  it("re-queues a batch after a transport error without bisecting", async () => {
+    const { pipeline, calls, failures, errors } = createPipeline();
+
+    pipeline.enqueue(items(3));
+    calls[0].reject(new Error(`sendTransaction timed out`));
+    await waitFor(() => errors.length === 1);
+
+    expect(errors[0].items).toEqual(items(3));
+    expect(failures).toEqual([]);
+    // backing off
+    expect(calls.length).toEqual(1);
+    expect(pipeline.backlog).toEqual(3);
+
+    // the whole batch is retried after the backoff
+    await new Promise((resolve) => setTimeout(resolve, 1100));
+    expect(calls.map((c) => c.items)).toEqual([items(3), items(3)]);
+    calls[1].resolve();
+    await waitFor(() => pipeline.pending === 0);
+    expect(pipeline.backlog).toEqual(0);
+  });
+
+  it("halves the window on resource errors and grows it on success", async () => {
+    const { pipeline, calls } = createPipeline({
+      maxInFlight: 4,
+      maxBatchSize: 1,
+    });
+
+    pipeline.enqueue([`t0`]);
+    calls[0].reject(cpuExceeded());
+    await waitFor(() => pipeline.pending === 0);
+
+    pipeline.enqueue(items(5));
+    await new Promise((resolve) => setTimeout(resolve, 1100));
+    // window 4 / 2
+    expect(pipeline.pending).toEqual(2);
+
+    calls[1].resolve();
+    await waitFor(() => calls.length === 5);
+    // window 2 + 1
+    expect(pipeline.pending).toEqual(3);
+  });
+
+  it("skips settled items until the settle window passed", async () => {
+    const { pipeline, calls } = createPipeline({
+      settleMs: 50,
+      respond: () => Promise.resolve(),
+    });
+
+    pipeline.enqueue([`t0`]);
+    await waitFor(() => pipeline.pending === 0);
+    pipeline.markSettled(`t1`, Date.now());
+
+    pipeline.enqueue([`t0`, `t1`]);
+    expect(calls.length).toEqual(1);
+    expect(pipeline.isActive(`t1`)).toBe(true);
+
+    await new Promise((resolve) => setTimeout(resolve, 60));
+    expect(pipeline.isActive(`t1`)).toBe(false);
+    pipeline.enqueue([`t0`, `t1`]);
+    expect(calls.map((c) => c.items)).toEqual([[`t0`], [`t0`, `t1`]]);
+  });
+});
@@ -0,0 +1,194 @@
+import { RpcError } from "eosjs";
+import { extractRpcError } from ".";
+
+// transaction was rejected because the account ran out of CPU / NET or the
+// node was too busy, retrying right away only makes it worse
+export const isResourceError = (error: any) =>
+  /tx_cpu_usage_exceeded|tx_net_usage_exceeded|leeway_deadline_exception|deadline_exception|billed cpu time|net usage|cpu usage/i.test(
+    extractRpcError(error) || ``
+  );
+
+// an action of the transaction failed a contract check. Anything else, an
+// unreachable node, HTTP errors, timeouts or an expired / TaPoS-rejected
+// transaction, says nothing about the actions and is retried
+export const isActionFailure = (error: any) =>
+  error instanceof RpcError &&
+  /eosio_assert_message_exception|eosio_assert_code_exception/.test(
+    (error.json && error.json.error && error.json.error.name) || ``
+  );
+
+const MIN_BACKOFF_MS = 1000;
+const MAX_BACKOFF_MS = 60 * 1e3;
+
+type TPipelineOptions<T> = {
+  // items with a key that is in flight or settled are not submitted again
+  key: (item: T) => string;
+  // sends all items in a single transaction
+  submit: (items: T[]) => Promise<void>;
+  // upper bound of concurrently submitted transactions
+  maxInFlight: number;
+  // actions per transaction, limited by their summed estimated cost
+  maxBatchSize: number;
+  batchBudget: number;
+  cost: (item: T) => number;
+  // how long a submitted item is skipped, until the polled tables reflect it
+  settleMs: number;
+  // called with the items of every transaction right before it is sent
+  onSubmitted?: (items: T[]) => void;
+  // a single item failed a contract check on its own, after bisecting
+  onFailure: (item: T, error: any) => Promise<void> | void;
+  // transaction will be retried (resource limit, node or network error), or
+  // onFailure threw
+  onError: (items: T[], error: any) => void;
+};
+
+// packs queued items into transactions and submits them concurrently within
+// a bounded window. The window shrinks on resource errors and grows back on
+// success (AIMD), any retryable error backs off; a batch failing a contract
+// check is bisected so that a single bad action does not block the rest.
+export default class SubmissionPipeline<T> {
+  options: TPipelineOptions<T>;
+  private queue: T[] = [];
+  private inFlight: { [key: string]: boolean } = {};
+  private inFlightCount = 0;
+  private settled: { [key: string]: number } = {};
+  private window: number;
+  private backoffMs = 0;
+  private backoffUntil = 0;
+  private backoffTimer: ReturnType<typeof setTimeout> = null;
+
+  constructor(options: TPipelineOptions<T>) {
+    this.options = options;
+    this.window = options.maxInFlight;
+  }
+
+  get backlog() {
+    return this.queue.length;
+  }
+
+  get pending() {
+    return this.inFlightCount;
+  }
+
+  // the key is in flight or was submitted within the settle window
+  isActive(key: string) {
+    const settledAt = this.settled[key];
+    return (
+      !!this.inFlight[key] ||
+      (settledAt !== undefined &&
+        Date.now() - settledAt <= this.options.settleMs)
+    );
+  }
+
+  // skips a key that was submitted at the given time, e.g. before a restart
+  markSettled(key: string, at: number) {
+    this.settled[key] = Math.max(this.settled[key] || 0, at);
+  }
+
+  // replaces the queue with the actionable items of the latest poll
+  enqueue(items: T[]) {
+    const now = Date.now();
+    Object.keys(this.settled).forEach((key) => {
+      if (now - this.settled[key] > this.options.settleMs)
+        delete this.settled[key];
+    });
+
+    this.queue = items.filter((item) => {
+      const key = this.options.key(item);
+      return !this.inFlight[key] && !this.settled[key];
+    });
+    this.pump();
+  }
+
+  private pump() {
+    const now = Date.now();
+    if (now < this.backoffUntil) {
+      if (!this.backoffTimer) {
+        this.backoffTimer = setTimeout(() => {
+          this.backoffTimer = null;
+          this.pump();
+        }, this.backoffUntil - now);
+      }
+      return;
+    }
+
+    while (this.inFlightCount < this.window && this.queue.length > 0) {
+      this.run(this.nextBatch());
+    }
+  }
+
+  private nextBatch() {
+    const { maxBatchSize, batchBudget, cost } = this.options;
+    const batch = [this.queue.shift()];
+    let batchCost = cost(batch[0]);
+
+    while (
+      this.queue.length > 0 &&
+      batch.length < maxBatchSize &&
+      batchCost + cost(this.queue[0]) <= batchBudget
+    ) {
+      batchCost += cost(this.queue[0]);
+      batch.push(this.queue.shift());
+    }
+    return batch;
+  }
+
+  private async run(batch: T[]) {
+    const keys = batch.map(this.options.key);
+    keys.forEach((key) => (this.inFlight[key] = true));
+    this.inFlightCount += 1;
+
+    try {
+      await this.submitBisecting(batch);
+      this.window = Math.min(this.options.maxInFlight, this.window + 1);
+      this.backoffMs = 0;
+    } catch (error) {
+      // retryable error, retry the unsettled items after the backoff
+      if (isResourceError(error))
+        this.window = Math.max(1, Math.floor(this.window / 2));
+      this.backoffMs = Math.min(
+        MAX_BACKOFF_MS,
+        Math.max(MIN_BACKOFF_MS, this.backoffMs * 2)
+      );
+      this.backoffUntil = Date.now() + this.backoffMs;
+      const unsettled = batch.filter(
+        (item) => !this.settled[this.options.key(item)]
+      );
+      this.queue = unsettled.concat(this.queue);
+      this.options.onError(unsettled, error);
+    } finally {
+      keys.forEach((key) => delete this.inFlight[key]);
+      this.inFlightCount -= 1;
+      this.pump();
+    }
+  }
+
+  // throws on retryable errors, only contract check failures are bisected
+  private async submitBisecting(batch: T[]): Promise<void> {
+    try {
+      if (this.options.onSubmitted) this.options.onSubmitted(batch);
+      await this.options.submit(batch);
+      const now = Date.now();
+      batch.forEach((item) => (this.settled[this.options.key(item)] = now));
+      return;
+    } catch (error) {
+      if (!isActionFailure(error)) throw error;
+
+      if (batch.length > 1) {
+        const half = Math.ceil(batch.length / 2);
+        await this.submitBisecting(batch.slice(0, half));
+        await this.submitBisecting(batch.slice(half));
+        return;
+      }
+
+      try {
+        await this.options.onFailure(batch[0], error);
+      } catch (failureError) {
+        if (!isActionFailure(failureError)) throw failureError;
+        this.options.onError(batch, failureError);
+      }
+      // do not hammer the chain with an item that keeps failing
+      this.settled[this.options.key(batch[0])] = Date.now();
+    }
+  }
+}
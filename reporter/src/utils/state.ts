@@ -0,0 +1,156 @@
+import fs from "fs";
+import path from "path";
+import { NetworkName } from "../types";
+import { TEventCheckpoint } from "../eos/events";
+
+type TStateRecord =
+  // block and time (ms) at which the transfer was first seen, and when it
+  // expires (ms)
+  | { t: `seen`; id: string; block: number; at: number; exp: number }
+  // transaction submitted for a pipeline key at time (ms)
+  | { t: `sent`; key: string; at: number }
+  // event log position and global sequence, the last record wins
+  | { t: `events`; position: number; sequence: number };
+
+// rewrite the file once it holds this many more records than live entries
+const COMPACT_THRESHOLD = 10000;
+
+// Append-only local state of a reporter, reloaded on restart so that known
+// transfers do not wait for irreversibility again, recently submitted
+// transactions are not sent twice and the event log is not re-read.
+export default class ReporterState {
+  filePath: string;
+  firstSeen: {
+    [transferId: string]: { block: number; at: number; exp: number };
+  } = {};
+  sent: { [key: string]: number } = {};
+  events?: TEventCheckpoint;
+  // how long a sent entry is kept, the pipelines' settle time
+  sentTtlMs: number;
+  private records = 0;
+
+  constructor(network: NetworkName, sentTtlMs: number) {
+    const dir = process.env.STATE_DIR || `state`;
+    fs.mkdirSync(dir, { recursive: true });
+    this.filePath = path.resolve(dir, `${network}.jsonl`);
+    this.sentTtlMs = sentTtlMs;
+    this.load();
+  }
+
+  recordFirstSeen(
+    entries: { id: string; block: number; at: number; exp: number }[]
+  ) {
+    entries.forEach(({ id, block, at, exp }) => {
+      this.firstSeen[id] = { block, at, exp };
+    });
+    this.append(
+      entries.map(({ id, block, at, exp }) => ({
+        t: `seen`,
+        id,
+        block,
+        at,
+        exp,
+      }))
+    );
+  }
+
+  recordSent(keys: string[]) {
+    const at = Date.now();
+    keys.forEach((key) => (this.sent[key] = at));
+    this.append(keys.map((key) => ({ t: `sent`, key, at })));
+  }
+
+  recordEventCheckpoint(checkpoint: TEventCheckpoint) {
+    if (
+      this.events &&
+      this.events.position === checkpoint.position &&
+      this.events.sequence === checkpoint.sequence
+    )
+      return;
+    this.events = checkpoint;
+    this.append([{ t: `events`, ...checkpoint }]);
+  }
+
+  // expired transfers can never be reported again, drop them from memory;
+  // the file is cleaned up by the next compaction
+  evictExpired(now = Date.now()) {
+    Object.keys(this.firstSeen).forEach((id) => {
+      if (this.firstSeen[id].exp <= now) delete this.firstSeen[id];
+    });
+    Object.keys(this.sent).forEach((key) => {
+      if (now - this.sent[key] > this.sentTtlMs) delete this.sent[key];
+    });
+  }
+
+  private get liveCount() {
+    return (
+      Object.keys(this.firstSeen).length +
+      Object.keys(this.sent).length +
+      (this.events ? 1 : 0)
+    );
+  }
+
+  private load() {
+    if (!fs.existsSync(this.filePath)) return;
+
+    fs.readFileSync(this.filePath, `utf8`)
+      .split(`\n`)
+      .forEach((line) => {
+        if (!line.trim()) return;
+        let record: TStateRecord;
+        try {
+          record = JSON.parse(line);
+        } catch {
+          // torn write of the last line on a crash
+          return;
+        }
+        if (record.t === `seen`)
+          this.firstSeen[record.id] = {
+            block: record.block,
+            at: record.at,
+            exp: record.exp,
+          };
+        else if (record.t === `sent`) this.sent[record.key] = record.at;
+        else if (record.t === `events`)
+          this.events = { position: record.position, sequence: record.sequence };
+      });
+
+    this.evictExpired();
+    this.compact();
+  }
+
+  private append(records: TStateRecord[]) {
+    if (records.length === 0) return;
+
+    fs.appendFileSync(
+      this.filePath,
+      records.map((r) => `${JSON.stringify(r)}\n`).join(``)
+    );
+    this.records += records.length;
+
+    if (this.records > this.liveCount + COMPACT_THRESHOLD) {
+      this.evictExpired();
+      this.compact();
+    }
+  }
+
+  // writes only the live entries and atomically replaces the file
+  private compact() {
+    const records: TStateRecord[] = [];
+    Object.keys(this.firstSeen).forEach((id) =>
+      records.push({ t: `seen`, id, ...this.firstSeen[id] })
+    );
+    Object.keys(this.sent).forEach((key) =>
+      records.push({ t: `sent`, key, at: this.sent[key] })
+    );
+    if (this.events) records.push({ t: `events`, ...this.events });
+
+    const tmpPath = `${this.filePath}.tmp`;
+    fs.writeFileSync(
+      tmpPath,
+      records.map((r) => `${JSON.stringify(r)}\n`).join(``)
+    );
+    fs.renameSync(tmpPath, this.filePath);
+    this.records = records.length;
+  }
+}